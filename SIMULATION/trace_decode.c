@@ -0,0 +1,337 @@
+/* Build: cc -O2 trace_decode.c -o trace_decode */
+
+/*
+ * Decoder for the binary event traces written by CLL.C --event-trace.
+ *
+ *   trace_decode TRACE [--csv FILE] [--orders FILE] [--columns PREFIX]
+ *
+ *   --csv      one row per event: time,order,event,stage,express
+ *   --orders   one row per order with its outcome, as orders_detailed_c.csv
+ *              but including cancelled orders and those still in the system
+ *   --columns  one raw file per field in native byte order
+ *              (PREFIX.time.f64, ...) plus PREFIX.schema describing them,
+ *              for columnar tools
+ *
+ * Any combination is produced in a single pass over the trace.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define EVENT_MAGIC   "SIMEVT1"  // must match CLL.C
+#define READ_BLOCK    65536      // events per read
+#define OUT_BUFFER    (1 << 20)  // stdio buffer for each output file
+
+/* -------------------------------------------------------------------
+   Trace records, laid out exactly as CLL.C writes them
+   ------------------------------------------------------------------- */
+
+typedef struct {
+    double time;
+    uint32_t order;
+    uint8_t type;
+    uint8_t stage;
+    uint8_t express;
+    uint8_t pad;
+} TraceEvent;
+
+enum {
+    TE_ARRIVAL  = 0,
+    TE_STAGE    = 1,
+    TE_CANCEL   = 2,
+    TE_DELIVERY = 3
+};
+
+static const char *const event_names[] = {"ARRIVAL", "STAGE", "CANCELLED", "DELIVERED"};
+
+static const char *const stage_names[] = {
+    "PLACED", "PACKED", "DISPATCHED", "OUT_FOR_DELIVERY", "DELIVERED"
+};
+
+const char* event_name(int t) {
+    return t >= 0 && t <= TE_DELIVERY ? event_names[t] : "UNKNOWN";
+}
+
+const char* stage_name(int s) {
+    return s >= 0 && s <= 4 ? stage_names[s] : "UNKNOWN";
+}
+
+/* -------------------------------------------------------------------
+   Orders in flight, keyed by id (open addressing, linear probing)
+   ------------------------------------------------------------------- */
+
+typedef struct {
+    uint32_t id;         /* 0: empty slot */
+    uint8_t express;
+    uint8_t stage;
+    double arrival;
+} Pending;
+
+typedef struct {
+    Pending *slot;
+    size_t cap;          /* power of two */
+    size_t len;
+} PendingMap;
+
+size_t pending_home(const PendingMap *m, uint32_t id) {
+    return (size_t)(id * 2654435761u) & (m->cap - 1);
+}
+
+int pending_init(PendingMap *m, size_t cap) {
+    m->slot = (Pending*)calloc(cap, sizeof(Pending));
+    m->cap  = cap;
+    m->len  = 0;
+    return m->slot != NULL;
+}
+
+Pending* pending_find(PendingMap *m, uint32_t id) {
+    for (size_t i = pending_home(m, id);; i = (i + 1) & (m->cap - 1)) {
+        if (m->slot[i].id == id) return &m->slot[i];
+        if (m->slot[i].id == 0)  return NULL;
+    }
+}
+
+int pending_put(PendingMap *m, const Pending *p) {
+    if (2 * (m->len + 1) > m->cap) {
+        PendingMap bigger;
+        if (!pending_init(&bigger, m->cap * 2)) return 0;
+        for (size_t i = 0; i < m->cap; i++)
+            if (m->slot[i].id) pending_put(&bigger, &m->slot[i]);
+        free(m->slot);
+        *m = bigger;
+    }
+    size_t i = pending_home(m, p->id);
+    while (m->slot[i].id != 0 && m->slot[i].id != p->id) i = (i + 1) & (m->cap - 1);
+    if (m->slot[i].id == 0) m->len++;
+    m->slot[i] = *p;
+    return 1;
+}
+
+/* remove by shifting later members of the probe run back into the gap */
+void pending_remove(PendingMap *m, Pending *p) {
+    size_t gap = (size_t)(p - m->slot);
+    size_t i = gap;
+    for (;;) {
+        i = (i + 1) & (m->cap - 1);
+        if (m->slot[i].id == 0) break;
+        size_t home = pending_home(m, m->slot[i].id);
+        /* the entry may move into the gap if its home is not in (gap, i] */
+        if (((i - home) & (m->cap - 1)) >= ((i - gap) & (m->cap - 1))) {
+            m->slot[gap] = m->slot[i];
+            gap = i;
+        }
+    }
+    m->slot[gap].id = 0;
+    m->len--;
+}
+
+/* -------------------------------------------------------------------
+   Outputs
+   ------------------------------------------------------------------- */
+
+enum { COL_TIME, COL_ORDER, COL_TYPE, COL_STAGE, COL_EXPRESS, NUM_COLUMNS };
+
+static const char *const column_suffix[NUM_COLUMNS] = {
+    "time.f64", "order.u32", "type.u8", "stage.u8", "express.u8"
+};
+
+typedef struct {
+    FILE *csv;
+    FILE *orders;
+    FILE *col[NUM_COLUMNS];
+    PendingMap pending;
+    long events;
+    long unmatched;      /* stage, cancel or delivery of an unknown order */
+} Decoder;
+
+FILE* open_out(const char *path, const char *mode) {
+    FILE *fp = fopen(path, mode);
+    if (!fp) {
+        perror(path);
+        return NULL;
+    }
+    setvbuf(fp, NULL, _IOFBF, OUT_BUFFER);
+    return fp;
+}
+
+void order_row(FILE *fp, const Pending *p, double end, const char *outcome, int stage) {
+    if (end >= 0.0)
+        fprintf(fp, "%u,%d,%.3f,%.3f,%s,%s,%.3f\n", p->id, p->express, p->arrival, end,
+                outcome, stage_name(stage), end - p->arrival);
+    else
+        fprintf(fp, "%u,%d,%.3f,,%s,%s,\n", p->id, p->express, p->arrival,
+                outcome, stage_name(stage));
+}
+
+int decode_orders(Decoder *d, const TraceEvent *e) {
+    if (e->type == TE_ARRIVAL) {
+        Pending p;
+        p.id      = e->order;
+        p.express = e->express;
+        p.stage   = e->stage;
+        p.arrival = e->time;
+        return pending_put(&d->pending, &p);
+    }
+
+    Pending *p = pending_find(&d->pending, e->order);
+    if (!p) {
+        d->unmatched++;
+        return 1;
+    }
+    if (e->type == TE_STAGE) {
+        p->stage = e->stage;
+    } else {
+        int delivered = e->type == TE_DELIVERY;
+        order_row(d->orders, p, e->time, delivered ? "DELIVERED" : "CANCELLED", e->stage);
+        pending_remove(&d->pending, p);
+    }
+    return 1;
+}
+
+int decode_block(Decoder *d, const TraceEvent *ev, size_t n) {
+    if (d->csv)
+        for (size_t i = 0; i < n; i++)
+            fprintf(d->csv, "%.6f,%u,%s,%s,%d\n", ev[i].time, ev[i].order,
+                    event_name(ev[i].type), stage_name(ev[i].stage), ev[i].express);
+
+    if (d->orders)
+        for (size_t i = 0; i < n; i++)
+            if (!decode_orders(d, &ev[i])) return 0;
+
+    if (d->col[0])
+        for (size_t i = 0; i < n; i++) {
+            fwrite(&ev[i].time,    sizeof(double),   1, d->col[COL_TIME]);
+            fwrite(&ev[i].order,   sizeof(uint32_t), 1, d->col[COL_ORDER]);
+            fwrite(&ev[i].type,    1, 1, d->col[COL_TYPE]);
+            fwrite(&ev[i].stage,   1, 1, d->col[COL_STAGE]);
+            fwrite(&ev[i].express, 1, 1, d->col[COL_EXPRESS]);
+        }
+
+    d->events += (long)n;
+    return 1;
+}
+
+int write_schema(const char *prefix, long rows) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s.schema", prefix);
+    FILE *fp = open_out(path, "w");
+    if (!fp) return 0;
+
+    fprintf(fp, "# %ld rows, native byte order, one file per column\n", rows);
+    fprintf(fp, "time     float64  %s.%s\n", prefix, column_suffix[COL_TIME]);
+    fprintf(fp, "order    uint32   %s.%s\n", prefix, column_suffix[COL_ORDER]);
+    fprintf(fp, "type     uint8    %s.%s   0 ARRIVAL, 1 STAGE, 2 CANCELLED, 3 DELIVERED\n",
+            prefix, column_suffix[COL_TYPE]);
+    fprintf(fp, "stage    uint8    %s.%s   0 PLACED, 1 PACKED, 2 DISPATCHED, "
+                "3 OUT_FOR_DELIVERY, 4 DELIVERED\n", prefix, column_suffix[COL_STAGE]);
+    fprintf(fp, "express  uint8    %s.%s\n", prefix, column_suffix[COL_EXPRESS]);
+    return fclose(fp) == 0;
+}
+
+/* -------------------------------------------------------------------
+   Main
+   ------------------------------------------------------------------- */
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s TRACE [--csv FILE] [--orders FILE] [--columns PREFIX]\n"
+            "  --csv      one row per event\n"
+            "  --orders   one row per order: delivered, cancelled or still in the system\n"
+            "  --columns  raw per-field column files PREFIX.<field>.<type> and PREFIX.schema\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    const char *trace = NULL, *csv = NULL, *orders = NULL, *columns = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)          csv = argv[++i];
+        else if (strcmp(argv[i], "--orders") == 0 && i + 1 < argc)  orders = argv[++i];
+        else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc) columns = argv[++i];
+        else if (argv[i][0] != '-' && !trace)                        trace = argv[i];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!trace || (!csv && !orders && !columns)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(trace, "rb");
+    if (!in) {
+        perror(trace);
+        return 1;
+    }
+    char header[16];
+    uint32_t size;
+    if (fread(header, 1, sizeof(header), in) != sizeof(header) ||
+        memcmp(header, EVENT_MAGIC, 8) != 0) {
+        fprintf(stderr, "%s: not an event trace\n", trace);
+        fclose(in);
+        return 1;
+    }
+    memcpy(&size, header + 8, 4);
+    if (size != sizeof(TraceEvent)) {
+        fprintf(stderr, "%s: %u-byte records, expected %zu\n", trace, size, sizeof(TraceEvent));
+        fclose(in);
+        return 1;
+    }
+
+    Decoder d;
+    memset(&d, 0, sizeof(d));
+    int ok = 1;
+
+    if (csv && (d.csv = open_out(csv, "w")) != NULL)
+        fprintf(d.csv, "time,order,event,stage,express\n");
+    if (orders && (d.orders = open_out(orders, "w")) != NULL)
+        fprintf(d.orders, "id,express,arrival,end,outcome,final_stage,time_in_system\n");
+    if (orders && !pending_init(&d.pending, 1024)) ok = 0;
+    if (columns)
+        for (int c = 0; c < NUM_COLUMNS; c++) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s.%s", columns, column_suffix[c]);
+            if (!(d.col[c] = open_out(path, "wb"))) ok = 0;
+        }
+    if ((csv && !d.csv) || (orders && !d.orders)) ok = 0;
+
+    TraceEvent *buf = (TraceEvent*)malloc(sizeof(TraceEvent) * READ_BLOCK);
+    if (!buf) ok = 0;
+
+    size_t n;
+    while (ok && (n = fread(buf, sizeof(TraceEvent), READ_BLOCK, in)) > 0)
+        if (!decode_block(&d, buf, n)) ok = 0;
+    if (ok && ferror(in)) {
+        perror(trace);
+        ok = 0;
+    }
+
+    /* orders the run ended with */
+    if (ok && d.orders)
+        for (size_t i = 0; i < d.pending.cap; i++)
+            if (d.pending.slot[i].id)
+                order_row(d.orders, &d.pending.slot[i], -1.0, "IN_SYSTEM", d.pending.slot[i].stage);
+
+    if (d.csv && fclose(d.csv) != 0) ok = 0;
+    if (d.orders && fclose(d.orders) != 0) ok = 0;
+    for (int c = 0; c < NUM_COLUMNS; c++)
+        if (d.col[c] && fclose(d.col[c]) != 0) ok = 0;
+    if (ok && columns && !write_schema(columns, d.events)) ok = 0;
+
+    fclose(in);
+    free(buf);
+    free(d.pending.slot);
+
+    if (!ok) {
+        fprintf(stderr, "Decoding %s failed.\n", trace);
+        return 1;
+    }
+    printf("%ld events decoded", d.events);
+    if (d.orders) printf(", %zu order(s) still in the system at the end", d.pending.len);
+    if (d.unmatched) printf(", %ld event(s) for unknown orders", d.unmatched);
+    printf("\n");
+    return 0;
+}
@@ -1,12 +1,44 @@
+/* Build: cc -O2 -pthread SRMS.c -o srms */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <stdarg.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <float.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 #define STUD_FILE "students.dat"
+#define SLOT_FILE "students.slots"
 #define TKT_FILE  "tickets.dat"
 #define CSV_FILE  "students.csv"
 #define TXT_FILE  "students.txt"
-#define MAX_STUDENTS 2000
+#define JSON_FILE "students.json"
+#define IDX_FILE  "students.idx"
+#define CSV_STALE_FILE "students.csv.stale"
+#define TMP_FILE  "tmp.dat"
+#define LOCK_FILE "srms.lock"
+
+/* Compaction runs once dead records pass this share of the file. */
+#define COMPACT_DEAD_RATIO 0.25
+#define COMPACT_MIN_DEAD   64
+#define COMPACT_MIN_GARBAGE (64 * 1024)
 
 typedef struct {
     char id[20];
@@ -25,6 +57,20 @@ typedef struct {
     char status[10];
 } Ticket;
 
+/* CGPA is on a 10-point scale; NaN fails both comparisons. */
+#define CGPA_MAX 10.0f
+
+int cgpaValid(float cgpa) {
+    return cgpa >= 0.0f && cgpa <= CGPA_MAX;
+}
+
+/* Pull a stored CGPA into range (NaN becomes 0) for records that predate
+   the range check. */
+float cgpaClamp(float cgpa) {
+    if (cgpaValid(cgpa)) return cgpa;
+    return cgpa > CGPA_MAX ? CGPA_MAX : 0.0f;
+}
+
 /* ---------- INPUT HELPERS (NO scanf MIXING) ---------- */
 
 void readLine(char *buf, size_t size) {
@@ -59,407 +105,4258 @@ float readFloat() {
     }
 }
 
+float readCgpa() {
+    while (1) {
+        float x = readFloat();
+        if (cgpaValid(x))
+            return x;
+        printf("Enter a CGPA between 0 and %.0f: ", CGPA_MAX);
+    }
+}
+
 void pauseScreen() {
     printf("\nPress ENTER to continue...");
     char dummy[8];
     readLine(dummy, sizeof(dummy));
 }
 
-/* ---------- AUTH ---------- */
+/* ---------- WRITE-AHEAD LOG ---------- */
+
+/*
+ * Every write to students.dat or tickets.dat is first appended to
+ * students.wal as a redo record: target file, offset, the new bytes and a
+ * CRC. The data files are written with plain pwrite() and only fsync'd at
+ * a checkpoint, so a change costs one sequential log append instead of a
+ * file rewrite or a data-file fsync.
+ *
+ * walWrite() only logs a record and queues the data write. A data file is
+ * never written before its log record is on disk: walCommit() makes the
+ * log durable up to an LSN, and walApplySynced() then performs the queued
+ * writes up to that point, in log order. One logical change (an update,
+ * an append batch, a new ticket) ends with walFinish(), which does both
+ * with a single fsync however many records the change logged. In server
+ * mode walFinish() leaves that to the writer, which commits after
+ * releasing the database lock: the first committer to find no fsync in
+ * progress syncs on behalf of everyone who logged before it started, and
+ * the rest wait for that fsync instead of issuing their own (group
+ * commit). Until a queued write is applied, walRead() overlays it on
+ * reads of its file.
+ *
+ * walRecover() runs at startup and redoes every complete record, so an
+ * interrupted write is either finished or was never acknowledged. A
+ * checkpoint fsyncs the data files and empties the log; it runs when the
+ * log outgrows WAL_CHECKPOINT_BYTES, before compaction replaces
+ * students.dat, and at the end of every session.
+ */
+
+#define WAL_FILE  "students.wal"
+#define WAL_MAGIC 0x314C4157u   /* "WAL1" */
+#define WAL_CHECKPOINT_BYTES ((off_t)8 << 20)
+
+enum { WAL_STUDENTS, WAL_SLOTS, WAL_TICKETS, WAL_FILE_COUNT };
+static const char *const walPaths[WAL_FILE_COUNT] = { STUD_FILE, SLOT_FILE, TKT_FILE };
 
-int managementLogin() {
-    char u[32], p[32];
+typedef struct {
+    uint32_t magic;
+    uint32_t file;
+    uint64_t lsn;
+    int64_t  offset;
+    uint32_t len;
+    uint32_t crc;       /* of this header with crc = 0, then the data */
+} WalRecord;
+
+/* A logged write waiting for its record to reach disk. */
+typedef struct WalPending {
+    struct WalPending *next;
+    uint64_t lsn;
+    int file, fd;
+    off_t off;
+    size_t len;
+    unsigned char data[];
+} WalPending;
 
-    printf("----- MANAGEMENT LOGIN -----\n");
-    printf("Username: ");
-    readLine(u, sizeof(u));
+typedef struct {
+    int fd;
+    int autoCommit;     /* walFinish() commits and applies */
+    int syncing;        /* a committer is in fsync */
+    int applyFailed;    /* a data write failed; keep the log for recovery */
+    uint64_t lsn;       /* last record appended */
+    uint64_t synced;    /* last record known to be on disk */
+    off_t bytes;
+    WalPending *head, *tail;    /* queued writes, in LSN order */
+    pthread_mutex_t mu;
+    pthread_cond_t syncDone;
+    pthread_rwlock_t applyLock; /* held exclusively while writing the queue out */
+} WriteAheadLog;
+
+static WriteAheadLog wal = { -1, 1, 0, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER,
+                             PTHREAD_COND_INITIALIZER, PTHREAD_RWLOCK_INITIALIZER };
+static uint32_t crcTable[256];
+static pthread_once_t crcOnce = PTHREAD_ONCE_INIT;
+
+void crcInit() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+        crcTable[i] = c;
+    }
+}
 
-    printf("Password: ");
-    readLine(p, sizeof(p));
+uint32_t crc32Update(uint32_t crc, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    pthread_once(&crcOnce, crcInit);
+    crc = ~crc;
+    while (len--) crc = crcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
 
-    if (strcmp(u, "admin") == 0 && strcmp(p, "admin123") == 0) {
-        return 1;
+uint32_t walCrc(WalRecord h, const void *data) {
+    h.crc = 0;
+    return crc32Update(crc32Update(0, &h, sizeof(h)), data, h.len);
+}
+
+int writeAll(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, buf, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return 0;
+        buf += w;
+        len -= (size_t)w;
     }
-    return 0;
+    return 1;
 }
 
-int studentLogin(char outId[]) {
-    char id[20];
-    char pass[20];
-    Student s;
-    FILE *fp = fopen(STUD_FILE, "rb");
-    if (!fp) {
-        printf("No student database found. Please add students first via Management Login.\n");
+int pwriteAll(int fd, const void *data, size_t len, off_t off) {
+    const char *p = (const char *)data;
+    while (len > 0) {
+        ssize_t w = pwrite(fd, p, len, off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return 0;
+        p += w;
+        off += w;
+        len -= (size_t)w;
+    }
+    return 1;
+}
+
+int walOpen() {
+    if (wal.fd >= 0) return 1;
+    wal.fd = open(WAL_FILE, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (wal.fd < 0) {
+        perror("Cannot open write-ahead log");
         return 0;
     }
+    wal.bytes = lseek(wal.fd, 0, SEEK_END);
+    return 1;
+}
 
-    printf("----- STUDENT LOGIN -----\n");
-    printf("Student ID: ");
-    readLine(id, sizeof(id));
-    
-    printf("Password: ");
-    readLine(pass, sizeof(pass));
+uint64_t walLastLsn() {
+    pthread_mutex_lock(&wal.mu);
+    uint64_t lsn = wal.lsn;
+    pthread_mutex_unlock(&wal.mu);
+    return lsn;
+}
 
-    while (fread(&s, sizeof(Student), 1, fp) == 1) {
-        if (strcmp(s.id, id) == 0 && strcmp(s.password, pass) == 0) {
-            fclose(fp);
-            strcpy(outId, id);
-            return 1;
+/* Wait until every record up to lsn is on disk. */
+int walCommit(uint64_t lsn) {
+    int ok = 1;
+    pthread_mutex_lock(&wal.mu);
+    while (ok && wal.synced < lsn) {
+        if (wal.syncing) {
+            pthread_cond_wait(&wal.syncDone, &wal.mu);
+            continue;
         }
+        uint64_t upto = wal.lsn;
+        wal.syncing = 1;
+        pthread_mutex_unlock(&wal.mu);
+        ok = fdatasync(wal.fd) == 0;
+        pthread_mutex_lock(&wal.mu);
+        wal.syncing = 0;
+        if (ok && upto > wal.synced) wal.synced = upto;
+        pthread_cond_broadcast(&wal.syncDone);
     }
-
-    fclose(fp);
-    printf("\nInvalid credentials or student not found.\n");
-    return 0;
+    pthread_mutex_unlock(&wal.mu);
+    if (!ok) perror("Cannot sync write-ahead log");
+    return ok;
 }
 
-/* ---------- STUDENT FILE HELPERS ---------- */
-
-int loadAllStudents(Student arr[], int maxCount) {
-    FILE *fp = fopen(STUD_FILE, "rb");
-    if (!fp) return 0;
-    int n = 0;
-    while (n < maxCount && fread(&arr[n], sizeof(Student), 1, fp) == 1) {
-        n++;
+/* Write out, in log order, every queued write whose record is on disk. */
+int walApplySynced() {
+    int ok = 1;
+    pthread_rwlock_wrlock(&wal.applyLock);
+    while (1) {
+        pthread_mutex_lock(&wal.mu);
+        WalPending *p = wal.head;
+        if (p && p->lsn <= wal.synced) {
+            wal.head = p->next;
+            if (!wal.head) wal.tail = NULL;
+        } else {
+            p = NULL;
+        }
+        pthread_mutex_unlock(&wal.mu);
+        if (!p) break;
+        if (!pwriteAll(p->fd, p->data, p->len, p->off)) ok = 0;
+        free(p);
     }
-    fclose(fp);
-    return n;
+    if (!ok) {
+        wal.applyFailed = 1;            /* recovery redoes it from the log */
+        perror("Cannot write data file");
+    }
+    pthread_rwlock_unlock(&wal.applyLock);
+    return ok;
 }
 
-void saveAllStudents(Student arr[], int count) {
-    FILE *fp = fopen(STUD_FILE, "wb");
-    if (!fp) {
-        perror("Error writing students file");
-        return;
+/* Apply everything queued, fsync the data files, then empty the log. */
+int walCheckpoint() {
+    int ok = 1;
+    if (wal.fd < 0) return 1;
+    if (!walCommit(walLastLsn()) || !walApplySynced() || wal.applyFailed) return 0;
+    pthread_mutex_lock(&wal.mu);
+    while (wal.syncing) pthread_cond_wait(&wal.syncDone, &wal.mu);
+    if (wal.bytes > 0) {
+        for (int i = 0; i < WAL_FILE_COUNT; i++) {
+            int fd = open(walPaths[i], O_RDONLY);
+            if (fd < 0) continue;
+            if (fsync(fd) != 0) ok = 0;
+            close(fd);
+        }
+        if (ok && ftruncate(wal.fd, 0) == 0 && fsync(wal.fd) == 0) wal.bytes = 0;
+        else ok = 0;
     }
-    fwrite(arr, sizeof(Student), count, fp);
-    fclose(fp);
+    if (ok) {
+        wal.synced = wal.lsn;
+        pthread_cond_broadcast(&wal.syncDone);
+    } else {
+        perror("Cannot checkpoint write-ahead log");
+    }
+    pthread_mutex_unlock(&wal.mu);
+    return ok;
 }
 
-/* ---------- CSV EXPORT ---------- */
-
-void autoExportCSV() {
-    Student arr[MAX_STUDENTS];
-    int n = loadAllStudents(arr, MAX_STUDENTS);
-    if (n == 0) return;
-    
-    FILE *fp = fopen(CSV_FILE, "w");
-    if (!fp) return;
-    
-    fprintf(fp, "ID,Name,Branch,Section,CGPA,Phone\n");
-    for (int i = 0; i < n; i++) {
-        fprintf(fp, "%s,%s,%s,%s,%.2f,%s\n",
-                arr[i].id, arr[i].name, arr[i].branch, arr[i].section,
-                arr[i].cgpa, arr[i].phone);
+/* Log a write to one of the data files and queue it until its record is
+   on disk. */
+int walWrite(int file, int fd, const void *data, size_t len, off_t off) {
+    WalRecord h;
+    if (!walOpen()) return 0;
+    if (wal.bytes >= WAL_CHECKPOINT_BYTES && !walCheckpoint()) return 0;
+
+    WalPending *p = (WalPending *)malloc(sizeof(WalPending) + len);
+    if (!p) return 0;
+    p->next = NULL;
+    p->file = file;
+    p->fd = fd;
+    p->off = off;
+    p->len = len;
+    memcpy(p->data, data, len);
+
+    memset(&h, 0, sizeof(h));
+    h.magic = WAL_MAGIC;
+    h.file = (uint32_t)file;
+    h.offset = (int64_t)off;
+    h.len = (uint32_t)len;
+
+    pthread_mutex_lock(&wal.mu);
+    h.lsn = wal.lsn + 1;
+    h.crc = walCrc(h, data);
+    if (!writeAll(wal.fd, (const char *)&h, sizeof(h)) ||
+        !writeAll(wal.fd, (const char *)data, len)) {
+        perror("Cannot write write-ahead log");
+        if (ftruncate(wal.fd, wal.bytes) != 0) perror("Cannot repair write-ahead log");
+        pthread_mutex_unlock(&wal.mu);
+        free(p);
+        return 0;
     }
-    fclose(fp);
+    wal.lsn = p->lsn = h.lsn;
+    wal.bytes += (off_t)(sizeof(h) + len);
+    if (wal.tail) wal.tail->next = p;
+    else wal.head = p;
+    wal.tail = p;
+    pthread_mutex_unlock(&wal.mu);
+    return 1;
 }
 
-/* ---------- MANAGEMENT: CRUD ---------- */
+/* End one logical change: commit its records with one fsync, then apply
+   them. In server mode the writer does this itself (see dbWriteDone). */
+int walFinish() {
+    if (!wal.autoCommit) return 1;
+    return walCommit(walLastLsn()) && walApplySynced();
+}
 
-void addStudent() {
-    Student s;
-    memset(&s, 0, sizeof(Student));
-    FILE *fp = fopen(STUD_FILE, "ab");
-    if (!fp) {
-        perror("Cannot open student file");
-        pauseScreen();
-        return;
+/* pread() from a data file, with queued writes not applied yet laid over
+   the result. Returns 1 if all len bytes were read. */
+int walRead(int file, int fd, void *buf, size_t len, off_t off) {
+    unsigned char *dst = (unsigned char *)buf;
+    pthread_rwlock_rdlock(&wal.applyLock);
+    ssize_t r = pread(fd, buf, len, off);
+    size_t have = r > 0 ? (size_t)r : 0;
+    pthread_mutex_lock(&wal.mu);
+    for (const WalPending *p = wal.head; p; p = p->next) {
+        off_t lo = p->off > off ? p->off : off;
+        off_t hi = p->off + (off_t)p->len < off + (off_t)len ? p->off + (off_t)p->len
+                                                             : off + (off_t)len;
+        if (p->file != file || lo >= hi) continue;
+        memcpy(dst + (lo - off), p->data + (lo - p->off), (size_t)(hi - lo));
+        if ((size_t)(lo - off) <= have && (size_t)(hi - off) > have) have = (size_t)(hi - off);
     }
+    pthread_mutex_unlock(&wal.mu);
+    pthread_rwlock_unlock(&wal.applyLock);
+    return have == len;
+}
 
-    printf("----- ADD STUDENT -----\n");
-
-    printf("ID: ");
-    readLine(s.id, sizeof(s.id));
-
-    printf("Name: ");
-    readLine(s.name, sizeof(s.name));
-
-    printf("Branch: ");
-    readLine(s.branch, sizeof(s.branch));
-
-    printf("Section: ");
-    readLine(s.section, sizeof(s.section));
-
-    printf("CGPA: ");
-    s.cgpa = readFloat();
-
-    printf("Phone: ");
-    readLine(s.phone, sizeof(s.phone));
+/* Apply what is queued and close the log. Anything that cannot be
+   applied stays in the log for walRecover() on the next run. */
+void walClose() {
+    if (wal.fd < 0) return;
+    walCheckpoint();
+    pthread_mutex_lock(&wal.mu);
+    while (wal.head) {
+        WalPending *p = wal.head;
+        wal.head = p->next;
+        free(p);
+    }
+    wal.tail = NULL;
+    pthread_mutex_unlock(&wal.mu);
+    close(wal.fd);
+    wal.fd = -1;
+    wal.bytes = 0;
+}
 
-    snprintf(s.password, sizeof(s.password), "%s@pass", s.id);
+/* Redo every complete record left by an interrupted run, then start an
+   empty log. Returns the number of records replayed, or -1. */
+long walRecover() {
+    int fds[WAL_FILE_COUNT];
+    char *buf = NULL;
+    size_t cap = 0;
+    off_t pos = 0;
+    long n = 0;
+    int ok = 1;
+    WalRecord h;
+
+    if (!walOpen()) return -1;
+    for (int i = 0; i < WAL_FILE_COUNT; i++) fds[i] = -1;
+
+    while (pread(wal.fd, &h, sizeof(h), pos) == (ssize_t)sizeof(h) &&
+           h.magic == WAL_MAGIC && h.file < WAL_FILE_COUNT &&
+           (off_t)h.len <= wal.bytes - pos - (off_t)sizeof(h)) {
+        if (h.len > cap) {
+            char *grown = (char *)realloc(buf, h.len);
+            if (!grown) {
+                ok = 0;
+                break;
+            }
+            buf = grown;
+            cap = h.len;
+        }
+        if (pread(wal.fd, buf, h.len, pos + (off_t)sizeof(h)) != (ssize_t)h.len ||
+            walCrc(h, buf) != h.crc)
+            break;                              /* torn tail: never committed */
 
-    fwrite(&s, sizeof(Student), 1, fp);
-    fclose(fp);
+        if (fds[h.file] < 0) fds[h.file] = open(walPaths[h.file], O_RDWR | O_CREAT, 0644);
+        if (fds[h.file] < 0 || !pwriteAll(fds[h.file], buf, h.len, (off_t)h.offset)) {
+            ok = 0;
+            break;
+        }
+        wal.lsn = h.lsn;
+        pos += (off_t)sizeof(h) + (off_t)h.len;
+        n++;
+    }
+    free(buf);
+    for (int i = 0; i < WAL_FILE_COUNT; i++)
+        if (fds[i] >= 0) close(fds[i]);
 
-    printf("\nStudent added.\n");
-    printf("Default password: %s\n", s.password);
-    
-    autoExportCSV();
-    printf("CSV updated automatically.\n");
-    
-    pauseScreen();
+    if (!ok) {
+        perror("Cannot replay write-ahead log");
+        return -1;
+    }
+    if (wal.bytes > 0 && !walCheckpoint()) return -1;
+    return n;
 }
 
-void displayAll() {
-    Student s;
-    FILE *fp = fopen(STUD_FILE, "rb");
-    if (!fp) {
-        printf("No data.\n");
-        pauseScreen();
-        return;
-    }
+/* ---------- STUDENT STORE ---------- */
+
+/*
+ * students.dat starts with an 8 KiB header: magic number, format version,
+ * a layout ID, and the dictionaries that intern branch and section values
+ * to one-byte codes. A heap of compact, variable-length records follows.
+ * students.slots maps each record number to the offset and length of its
+ * record in the heap. A zero length means the student was deleted (a
+ * tombstone). The slot file carries the same layout ID as the heap it
+ * describes.
+ *
+ * A record holds:
+ *   - a flags byte
+ *   - ID and name as length-prefixed strings
+ *   - branch and section codes (code 0 means a literal string follows,
+ *     for values beyond the dictionary)
+ *   - the CGPA
+ *   - the phone number, packed two digits per byte when it is all digits
+ *   - the password, only when it is not the default "<id>@pass"
+ * A typical record is about 45 bytes instead of the 140 of a raw Student.
+ *
+ * The heap is mapped read-only. A record is decoded into an in-memory
+ * row the first time it is read. storeGet() hands out const views of
+ * those rows, so callers keep working with plain Student structs. A view
+ * stays valid until the next append or rewrite of the store. Server mode
+ * decodes every row up front, so its readers never write to the store.
+ *
+ * A write that fits in the record's old bytes overwrites them. A longer
+ * record is appended to the heap and its slot repointed. Both files change
+ * only through the write-ahead log. storeCompact() drops tombstones and
+ * unused heap bytes once they make up enough of the files.
+ *
+ * A students.dat in the original raw layout (packed Student structs, no
+ * header) is migrated on first open. The original file is kept as
+ * students.dat.v1.
+ */
+
+#define STORE_MAGIC      0x324D5253u   /* "SRM2" */
+#define STORE_VERSION    2u
+#define SLOT_MAGIC       0x544F4C53u   /* "SLOT" */
+#define STORE_HEAP_START 8192
+#define STORE_DICT_MAX   255
+#define REC_MAX          160           /* longest possible encoded record */
+#define REC_TYPICAL      48            /* usual record: coded branch/section, BCD phone */
+#define TMP_SLOT_FILE    "tmp.slots"
+#define RAW_BACKUP_FILE  "students.dat.v1"
+
+enum { REC_DEFAULT_PASS = 1, REC_PHONE_BCD = 2 };
 
-    FILE *txt = fopen(TXT_FILE, "w");
-    if (!txt) {
-        printf("Warning: Could not create %s (txt export will be skipped).\n", TXT_FILE);
-    }
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t layout;        /* changes whenever the heap is rewritten */
+    uint32_t nBranch;       /* dictionary codes in use, plus one */
+    uint32_t nSection;
+    char branch[STORE_DICT_MAX + 1][20];        /* code 0 is unused */
+    char section[STORE_DICT_MAX + 1][10];
+} StoreHeader;
 
-    printf("\n----- ALL STUDENTS -----\n");
-    if (txt) fprintf(txt, "----- ALL STUDENTS -----\n");
+typedef char storeHeaderFits[sizeof(StoreHeader) <= STORE_HEAP_START ? 1 : -1];
 
-    while (fread(&s, sizeof(Student), 1, fp) == 1) {
-        if (s.id[0] == '\0') continue;  
+typedef struct {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t layout;
+} SlotHeader;
 
-        printf("\nID: %s\nName: %s\nBranch: %s\nSection: %s\nCGPA: %.2f\nPhone: %s\n",
-               s.id, s.name, s.branch, s.section, s.cgpa, s.phone);
+typedef struct {
+    int fd, slotFd;
+    dev_t dev;
+    ino_t ino;
+    const unsigned char *base;
+    size_t mapBytes;
+    off_t heapEnd;
+    StoreHeader hdr;
+    uint64_t *slots;        /* offset << 16 | length */
+    Student *rows;          /* decoded records */
+    uint8_t *decoded;
+    long count, cap;
+    long dead;              /* tombstones, or -1 if not counted yet */
+    int64_t garbage;        /* heap bytes no slot points at, or -1 */
+} StudentStore;
+
+static StudentStore store = { -1, -1, 0, 0, NULL, 0, 0, { 0 }, NULL, NULL, NULL, 0, 0, -1, -1 };
+
+/* Set by server mode once everything is loaded: no other process can
+   touch the files, so loaded state never needs re-validating. */
+static int soleWriter = 0;
+static uint64_t storeGeneration = 1;   /* bumped whenever a stored record may change */
+
+int isLive(const Student *s) {
+    return s->id[0] != '\0';
+}
 
-        if (txt) {
-            fprintf(txt,
-                    "\nID: %s\nName: %s\nBranch: %s\nSection: %s\nCGPA: %.2f\nPhone: %s\n",
-                    s.id, s.name, s.branch, s.section, s.cgpa, s.phone);
-        }
-    }
+uint64_t slotMake(off_t off, size_t len) {
+    return (uint64_t)off << 16 | (uint64_t)len;
+}
 
-    fclose(fp);
-    if (txt) {
-        fclose(txt);
-        printf("\nData also written to %s\n", TXT_FILE);
-    }
+off_t slotOffset(uint64_t slot) {
+    return (off_t)(slot >> 16);
+}
 
-    pauseScreen();
+size_t slotLen(uint64_t slot) {
+    return (size_t)(slot & 0xFFFF);
 }
 
-void updateStudent() {
-    char id[20];
-    int found = 0;
-    Student s;
-    FILE *fp = fopen(STUD_FILE, "rb+");
-    if (!fp) {
-        printf("No student file.\n");
-        pauseScreen();
-        return;
-    }
+off_t slotPos(long rec) {
+    return (off_t)sizeof(SlotHeader) + (off_t)rec * (off_t)sizeof(uint64_t);
+}
 
-    printf("\nEnter ID to update: ");
-    readLine(id, sizeof(id));
+/* "<id>@pass", cut to fit the field for very long IDs. */
+void defaultPasswordOf(const char *id, char *out, size_t size) {
+    if (snprintf(out, size, "%s@pass", id) >= (int)size) out[size - 1] = '\0';
+}
 
-    while (fread(&s, sizeof(Student), 1, fp) == 1) {
-        if (strcmp(s.id, id) == 0) {
-            found = 1;
+/* Dictionary code of key, or 0 if it has none. */
+uint8_t dictFind(const char *keys, size_t width, uint32_t n, const char *key) {
+    for (uint32_t c = 1; c < n; c++)
+        if (strncmp(keys + c * width, key, width) == 0) return (uint8_t)c;
+    return 0;
+}
 
-            printf("New Name: ");
-            readLine(s.name, sizeof(s.name));
+/* Dictionary code of key, adding it if needed; 0 if the dictionary is full. */
+uint8_t dictCode(char *keys, size_t width, uint32_t *n, const char *key) {
+    uint8_t c = dictFind(keys, width, *n, key);
+    if (c != 0) return c;
+    if (*n > STORE_DICT_MAX) return 0;
+    char *slot = keys + *n * width;
+    memset(slot, 0, width);
+    memcpy(slot, key, strnlen(key, width - 1));
+    return (uint8_t)(*n)++;
+}
 
-            printf("New Branch: ");
-            readLine(s.branch, sizeof(s.branch));
+unsigned char *putStr(unsigned char *p, const char *s, size_t field) {
+    size_t n = strnlen(s, field - 1);
+    *p++ = (unsigned char)n;
+    memcpy(p, s, n);
+    return p + n;
+}
 
-            printf("New Section: ");
-            readLine(s.section, sizeof(s.section));
+const unsigned char *getStr(const unsigned char *p, const unsigned char *end,
+                            char *dst, size_t field) {
+    if (!p || p >= end) return NULL;
+    size_t n = *p++;
+    if (n >= field || (size_t)(end - p) < n) return NULL;
+    memcpy(dst, p, n);
+    dst[n] = '\0';
+    return p + n;
+}
 
-            printf("New CGPA: ");
-            s.cgpa = readFloat();
+/* An interned field: its code, or 0 and the literal string. */
+unsigned char *putCoded(unsigned char *p, char *keys, size_t width, uint32_t *n,
+                        const char *value) {
+    uint8_t code = dictCode(keys, width, n, value);
+    *p++ = code;
+    return code ? p : putStr(p, value, width);
+}
 
-            printf("New Phone: ");
-            readLine(s.phone, sizeof(s.phone));
+const unsigned char *getCoded(const unsigned char *p, const unsigned char *end,
+                              const char *keys, size_t width, uint32_t n, char *dst) {
+    if (!p || p >= end) return NULL;
+    uint8_t code = *p++;
+    if (code == 0) return getStr(p, end, dst, width);
+    if (code >= n) return NULL;
+    memcpy(dst, keys + code * width, width);
+    dst[width - 1] = '\0';
+    return p;
+}
 
-            fseek(fp, -(long)sizeof(Student), SEEK_CUR);
-            fwrite(&s, sizeof(Student), 1, fp);
-            break;
+/* Encode s into out (at least REC_MAX bytes), interning its branch and
+   section into h. Returns the encoded length. */
+size_t recEncode(const Student *s, StoreHeader *h, unsigned char *out) {
+    char defPass[sizeof(s->password)];
+    size_t phoneLen = strnlen(s->phone, sizeof(s->phone) - 1);
+    unsigned char flags = 0;
+    unsigned char *p = out + 1;
+
+    defaultPasswordOf(s->id, defPass, sizeof(defPass));
+    if (strncmp(s->password, defPass, sizeof(defPass)) == 0) flags |= REC_DEFAULT_PASS;
+    if (strspn(s->phone, "0123456789") == phoneLen) flags |= REC_PHONE_BCD;
+
+    p = putStr(p, s->id, sizeof(s->id));
+    p = putStr(p, s->name, sizeof(s->name));
+    p = putCoded(p, &h->branch[0][0], sizeof(h->branch[0]), &h->nBranch, s->branch);
+    p = putCoded(p, &h->section[0][0], sizeof(h->section[0]), &h->nSection, s->section);
+    memcpy(p, &s->cgpa, sizeof(float));
+    p += sizeof(float);
+    if (flags & REC_PHONE_BCD) {
+        *p++ = (unsigned char)phoneLen;
+        for (size_t i = 0; i < phoneLen; i += 2) {
+            unsigned hi = (unsigned)(s->phone[i] - '0');
+            unsigned lo = i + 1 < phoneLen ? (unsigned)(s->phone[i + 1] - '0') : 0xF;
+            *p++ = (unsigned char)(hi << 4 | lo);
         }
+    } else {
+        p = putStr(p, s->phone, sizeof(s->phone));
     }
+    if (!(flags & REC_DEFAULT_PASS)) p = putStr(p, s->password, sizeof(s->password));
 
-    fclose(fp);
+    out[0] = flags;
+    return (size_t)(p - out);
+}
 
-    if (found) {
-        printf("\nUpdated.\n");
-        autoExportCSV();
-        printf("CSV updated automatically.\n");
+/* Decode one record from the len bytes at p. Returns the bytes used, or
+   0 if they do not hold a valid record. */
+size_t recDecode(const unsigned char *p, size_t len, const StoreHeader *h, Student *s) {
+    const unsigned char *start = p, *end = p + len;
+    memset(s, 0, sizeof(*s));
+    if (len < 1) return 0;
+    unsigned char flags = *p++;
+
+    p = getStr(p, end, s->id, sizeof(s->id));
+    p = getStr(p, end, s->name, sizeof(s->name));
+    p = getCoded(p, end, &h->branch[0][0], sizeof(h->branch[0]), h->nBranch, s->branch);
+    p = getCoded(p, end, &h->section[0][0], sizeof(h->section[0]), h->nSection, s->section);
+    if (!p || (size_t)(end - p) < sizeof(float)) return 0;
+    memcpy(&s->cgpa, p, sizeof(float));
+    p += sizeof(float);
+
+    if (flags & REC_PHONE_BCD) {
+        if (p >= end) return 0;
+        size_t n = *p++;
+        if (n >= sizeof(s->phone) || (size_t)(end - p) < (n + 1) / 2) return 0;
+        for (size_t i = 0; i < n; i++) {
+            unsigned d = i % 2 == 0 ? p[i / 2] >> 4 : p[i / 2] & 0xF;
+            if (d > 9) return 0;
+            s->phone[i] = (char)('0' + d);
+        }
+        p += (n + 1) / 2;
     } else {
-        printf("\nID not found.\n");
+        p = getStr(p, end, s->phone, sizeof(s->phone));
     }
 
-    pauseScreen();
+    if (flags & REC_DEFAULT_PASS) defaultPasswordOf(s->id, s->password, sizeof(s->password));
+    else p = getStr(p, end, s->password, sizeof(s->password));
+    if (!p) {
+        memset(s, 0, sizeof(*s));
+        return 0;
+    }
+    return (size_t)(p - start);
 }
 
-void deleteStudent() {
-    char id[20];
-    int found = 0;
-    Student s;
-    FILE *fp = fopen(STUD_FILE, "rb");
-    FILE *tmp = fopen("tmp.dat", "wb");
+/* Make a finished temp file durable and rename it over path. */
+int replaceFile(FILE *tmp, const char *tmpPath, const char *path) {
+    int ok = fflush(tmp) == 0 && fsync(fileno(tmp)) == 0;
+    if (fclose(tmp) != 0) ok = 0;
+    if (ok && rename(tmpPath, path) == 0) {
+        int dir = open(".", O_RDONLY);
+        if (dir >= 0) {
+            fsync(dir);
+            close(dir);
+        }
+        return 1;
+    }
+    remove(tmpPath);
+    return 0;
+}
 
-    if (!fp || !tmp) {
-        printf("Error opening files.\n");
-        if (fp) fclose(fp);
-        if (tmp) fclose(tmp);
-        pauseScreen();
+void fileStampOf(const char *path, int64_t *size, int64_t *mtime) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        *size = 0;
+        *mtime = 0;
         return;
     }
+    *size  = (int64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+}
 
-    printf("\nEnter ID to delete: ");
-    readLine(id, sizeof(id));
+uint64_t newLayoutId() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec) ^ ((uint64_t)getpid() << 48);
+}
 
-    while (fread(&s, sizeof(Student), 1, fp) == 1) {
-        if (strcmp(s.id, id) == 0) {
-            found = 1;
-            continue;
+/*
+ * Write a fresh students.dat and students.slots holding recs in order (a
+ * NULL or tombstone entry keeps its record number as a tombstone). Both
+ * are built next to the originals and renamed over them, heap first. A
+ * crash between the renames leaves a slot file with the old layout ID,
+ * which storeLoadSlots() rebuilds from the new, gap-free heap.
+ */
+int storeWriteFiles(const Student *const *recs, long n) {
+    StoreHeader h;
+    SlotHeader sh = { SLOT_MAGIC, 0, 0 };
+    unsigned char buf[REC_MAX];
+    static const char pad[STORE_HEAP_START] = { 0 };
+
+    memset(&h, 0, sizeof(h));
+    h.magic = STORE_MAGIC;
+    h.version = STORE_VERSION;
+    h.layout = sh.layout = newLayoutId();
+    h.nBranch = h.nSection = 1;
+
+    FILE *dat = fopen(TMP_FILE, "wb");
+    FILE *sl = fopen(TMP_SLOT_FILE, "wb");
+    int ok = dat && sl && fwrite(pad, sizeof(pad), 1, dat) == 1 &&
+             fwrite(&sh, sizeof(sh), 1, sl) == 1;
+
+    off_t off = STORE_HEAP_START;
+    for (long i = 0; ok && i < n; i++) {
+        uint64_t slot = 0;
+        if (recs[i] && isLive(recs[i])) {
+            size_t len = recEncode(recs[i], &h, buf);
+            ok = fwrite(buf, 1, len, dat) == len;
+            slot = slotMake(off, len);
+            off += (off_t)len;
         }
-        fwrite(&s, sizeof(Student), 1, tmp);
+        if (ok) ok = fwrite(&slot, sizeof(slot), 1, sl) == 1;
     }
-
-    fclose(fp);
-    fclose(tmp);
-
-    remove(STUD_FILE);
-    rename("tmp.dat", STUD_FILE);
-
-    if (found) {
-        printf("Deleted.\n");
-        autoExportCSV();
-        printf("CSV updated automatically.\n");
+    if (ok) ok = fseek(dat, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, dat) == 1;
+
+    if (!ok) {
+        if (dat) fclose(dat);
+        if (sl) fclose(sl);
+        remove(TMP_FILE);
+        remove(TMP_SLOT_FILE);
+    } else if (!replaceFile(dat, TMP_FILE, STUD_FILE)) {
+        fclose(sl);
+        remove(TMP_SLOT_FILE);
+        ok = 0;
     } else {
-        printf("ID not found.\n");
+        ok = replaceFile(sl, TMP_SLOT_FILE, SLOT_FILE);
     }
-
-    pauseScreen();
+    if (!ok) perror("Error writing students file");
+    return ok;
 }
 
-void changeStudentId() {
-    char oldId[20], newId[20];
-    int found = 0;
-    Student s;
-    FILE *fp = fopen(STUD_FILE, "rb+");
-    if (!fp) {
-        printf("No student file.\n");
-        pauseScreen();
-        return;
+/* Convert a students.dat in the raw layout. */
+int storeMigrate(off_t size) {
+    long n = (long)(size / (off_t)sizeof(Student));
+    Student *raw = (Student *)malloc(sizeof(Student) * (n + 1));
+    const Student **recs = (const Student **)malloc(sizeof(*recs) * (n + 1));
+    FILE *fp = fopen(STUD_FILE, "rb");
+    int ok = raw && recs && fp && fread(raw, sizeof(Student), n, fp) == (size_t)n;
+    if (fp) fclose(fp);
+
+    if (ok) {
+        printf("Converting %s (%ld records) to the compact format...\n", STUD_FILE, n);
+        for (long i = 0; i < n; i++) recs[i] = &raw[i];
+        if (link(STUD_FILE, RAW_BACKUP_FILE) != 0 && errno != EEXIST)
+            perror("Cannot keep a copy of the raw student file");
+        ok = walCheckpoint() && storeWriteFiles(recs, n);
     }
+    free(raw);
+    free(recs);
+    if (!ok) fprintf(stderr, "Could not convert %s.\n", STUD_FILE);
+    return ok;
+}
 
-    printf("\nEnter old ID: ");
-    readLine(oldId, sizeof(oldId));
+void storeClose() {
+    if (store.base) munmap((void *)store.base, store.mapBytes);
+    if (store.fd >= 0) close(store.fd);
+    if (store.slotFd >= 0) close(store.slotFd);
+    free(store.slots);
+    free(store.rows);
+    free(store.decoded);
+    store.fd = store.slotFd = -1;
+    store.base = NULL;
+    store.mapBytes = 0;
+    store.slots = NULL;
+    store.rows = NULL;
+    store.decoded = NULL;
+    store.count = store.cap = 0;
+    store.dead = -1;
+    store.garbage = -1;
+    storeGeneration++;
+}
 
-    printf("Enter new ID: ");
-    readLine(newId, sizeof(newId));
+int storeMap(size_t need) {
+    size_t bytes = 2 * STORE_HEAP_START;
+    while (bytes < need) bytes *= 2;
+    if (store.base && bytes <= store.mapBytes) return 1;
 
-    while (fread(&s, sizeof(Student), 1, fp) == 1) {
-        if (strcmp(s.id, oldId) == 0) {
-            strcpy(s.id, newId);
-            snprintf(s.password, sizeof(s.password), "%s@pass", s.id);
-            fseek(fp, -(long)sizeof(Student), SEEK_CUR);
-            fwrite(&s, sizeof(Student), 1, fp);
-            found = 1;
-            break;
-        }
+    void *p = mmap(NULL, bytes, PROT_READ, MAP_SHARED, store.fd, 0);
+    if (p == MAP_FAILED) {
+        perror("Cannot map student file");
+        return 0;
     }
+    if (store.base) munmap((void *)store.base, store.mapBytes);
+    store.base = (const unsigned char *)p;
+    store.mapBytes = bytes;
+    return 1;
+}
 
-    fclose(fp);
+int storeReserve(long count) {
+    if (count <= store.cap) return 1;
+    long cap = store.cap ? store.cap : 1024;
+    while (cap < count) cap *= 2;
+    uint64_t *slots = (uint64_t *)realloc(store.slots, sizeof(uint64_t) * cap);
+    if (slots) store.slots = slots;
+    Student *rows = (Student *)realloc(store.rows, sizeof(Student) * cap);
+    if (rows) store.rows = rows;
+    uint8_t *decoded = (uint8_t *)realloc(store.decoded, cap);
+    if (decoded) store.decoded = decoded;
+    if (!slots || !rows || !decoded) return 0;
+    memset(store.decoded + store.cap, 0, (size_t)(cap - store.cap));
+    store.cap = cap;
+    return 1;
+}
 
-    if (found) {
-        printf("\nID changed.\n");
-        autoExportCSV();
-        printf("CSV updated automatically.\n");
-    } else {
-        printf("\nOld ID not found.\n");
+/* Rebuild students.slots by walking a gap-free heap. */
+int storeRebuildSlots() {
+    SlotHeader sh = { SLOT_MAGIC, 0, store.hdr.layout };
+    Student s;
+    off_t off = STORE_HEAP_START;
+    store.count = 0;
+    while (off < store.heapEnd) {
+        size_t len = recDecode(store.base + off, (size_t)(store.heapEnd - off), &store.hdr, &s);
+        if (len == 0 || !storeReserve(store.count + 1)) break;
+        store.slots[store.count++] = slotMake(off, len);
+        off += (off_t)len;
     }
 
-    pauseScreen();
+    FILE *fp = fopen(TMP_SLOT_FILE, "wb");
+    if (!fp) return 0;
+    fwrite(&sh, sizeof(sh), 1, fp);
+    fwrite(store.slots, sizeof(uint64_t), store.count, fp);
+    return replaceFile(fp, TMP_SLOT_FILE, SLOT_FILE);
 }
 
-/* ---------- ANALYTICS & SORTING ---------- */
-
-int cmpCgpaAsc(const void *a, const void *b) {
-    const Student *sa = (const Student *)a;
-    const Student *sb = (const Student *)b;
-    if (sa->cgpa < sb->cgpa) return -1;
-    if (sa->cgpa > sb->cgpa) return 1;
-    return strcmp(sa->name, sb->name);
+int storeLoadSlots() {
+    SlotHeader sh;
+    struct stat st;
+    int fd = open(SLOT_FILE, O_RDWR);
+    int ok = fd >= 0 && fstat(fd, &st) == 0 &&
+             pread(fd, &sh, sizeof(sh), 0) == (ssize_t)sizeof(sh) &&
+             sh.magic == SLOT_MAGIC && sh.layout == store.hdr.layout;
+    if (ok) {
+        long n = (long)((st.st_size - (off_t)sizeof(sh)) / (off_t)sizeof(uint64_t));
+        size_t bytes = sizeof(uint64_t) * (size_t)n;
+        ok = storeReserve(n) &&
+             pread(fd, store.slots, bytes, sizeof(sh)) == (ssize_t)bytes;
+        store.count = n;
+    } else {
+        if (fd >= 0) close(fd);
+        ok = storeRebuildSlots() && (fd = open(SLOT_FILE, O_RDWR)) >= 0;
+    }
+    if (!ok) {
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    store.slotFd = fd;
+    return 1;
 }
 
-int cmpCgpaDesc(const void *a, const void *b) {
-    return -cmpCgpaAsc(a, b);
+void storeDecode(long rec) {
+    uint64_t slot = store.slots[rec];
+    Student *s = &store.rows[rec];
+    if (slotLen(slot) == 0 ||
+        slotOffset(slot) + (off_t)slotLen(slot) > store.heapEnd ||
+        recDecode(store.base + slotOffset(slot), slotLen(slot), &store.hdr, s) == 0)
+        memset(s, 0, sizeof(*s));
+    store.decoded[rec] = 1;
 }
 
-int cmpNameAsc(const void *a, const void *b) {
-    const Student *sa = (const Student *)a;
-    const Student *sb = (const Student *)b;
-    return strcmp(sa->name, sb->name);
+void storeDecodeAll() {
+    for (long i = 0; i < store.count; i++)
+        if (!store.decoded[i]) storeDecode(i);
 }
 
-void showAnalytics() {
-    Student arr[MAX_STUDENTS];
-    int n = loadAllStudents(arr, MAX_STUDENTS);
-    if (n == 0) {
-        printf("\nNo students found.\n");
-        pauseScreen();
-        return;
+int storeLoad() {
+    struct stat st;
+    store.fd = open(STUD_FILE, O_RDWR);
+    if (store.fd < 0) return 0;
+    if (fstat(store.fd, &st) != 0 ||
+        pread(store.fd, &store.hdr, sizeof(store.hdr), 0) != (ssize_t)sizeof(store.hdr) ||
+        store.hdr.magic != STORE_MAGIC || store.hdr.version != STORE_VERSION ||
+        store.hdr.nBranch < 1 || store.hdr.nBranch > STORE_DICT_MAX + 1 ||
+        store.hdr.nSection < 1 || store.hdr.nSection > STORE_DICT_MAX + 1) {
+        fprintf(stderr, "%s is not a student file this version can read.\n", STUD_FILE);
+        storeClose();
+        return 0;
+    }
+    store.dev = st.st_dev;
+    store.ino = st.st_ino;
+    store.heapEnd = st.st_size;
+    if (!storeMap((size_t)store.heapEnd) || !storeLoadSlots()) {
+        storeClose();
+        return 0;
     }
+    if (soleWriter) storeDecodeAll();
+    return 1;
+}
 
-    float sum = 0.0f;
-    int hi = 0, lo = 0;
+/*
+ * Open the store, creating it if asked and converting a raw-layout file.
+ * Cheap when it is already open: one stat, to notice a file replaced by
+ * a rename. Returns 0 if students.dat does not exist and create is 0.
+ */
+int storeOpen(int create) {
+    struct stat st;
 
-    for (int i = 0; i < n; i++) {
-        sum += arr[i].cgpa;
-        if (arr[i].cgpa > arr[hi].cgpa) hi = i;
-        if (arr[i].cgpa < arr[lo].cgpa) lo = i;
+    if (soleWriter && store.fd >= 0) return 1;
+
+    if (store.fd >= 0) {
+        if (stat(STUD_FILE, &st) == 0 && st.st_dev == store.dev && st.st_ino == store.ino)
+            return 1;
+        storeClose();
     }
 
-    float avg = sum / n;
+    if (stat(STUD_FILE, &st) != 0) {
+        if (!create || !storeWriteFiles(NULL, 0)) return 0;
+    } else {
+        uint32_t head[2] = { 0, 0 };
+        FILE *fp = fopen(STUD_FILE, "rb");
+        if (!fp) return 0;
+        if (fread(head, sizeof(head), 1, fp) != 1) head[0] = 0;
+        fclose(fp);
+        if ((head[0] != STORE_MAGIC || head[1] != STORE_VERSION) && !storeMigrate(st.st_size))
+            return 0;
+    }
+    return storeLoad();
+}
 
-    printf("\n----- ANALYTICS -----\n");
-    printf("Total Students : %d\n", n);
-    printf("Average CGPA   : %.2f\n", avg);
+/* Size and mtime stamp that changes with every write to the store, for
+   the derived indexes to check themselves against. */
+void storeStamp(int64_t *size, int64_t *mtime) {
+    int64_t slotSize, slotMtime;
+    fileStampOf(STUD_FILE, size, mtime);
+    fileStampOf(SLOT_FILE, &slotSize, &slotMtime);
+    *size += slotSize;
+    if (slotMtime > *mtime) *mtime = slotMtime;
+}
 
-    printf("\nHighest CGPA:\n");
-    printf("ID: %s | Name: %s | CGPA: %.2f\n",
-           arr[hi].id, arr[hi].name, arr[hi].cgpa);
+long storeCount() {
+    return store.count;
+}
 
-    printf("\nLowest CGPA:\n");
-    printf("ID: %s | Name: %s | CGPA: %.2f\n",
-           arr[lo].id, arr[lo].name, arr[lo].cgpa);
+const Student *storeGet(long rec) {
+    if (!store.decoded[rec]) storeDecode(rec);
+    return &store.rows[rec];
+}
 
-    pauseScreen();
+int storeWriteSlot(long rec, uint64_t slot) {
+    if (!walWrite(WAL_SLOTS, store.slotFd, &slot, sizeof(slot), slotPos(rec))) return 0;
+    store.slots[rec] = slot;
+    return 1;
 }
 
+/* Persist the dictionaries after recEncode() added to them. */
+int storeSaveHeader(uint32_t nBranch, uint32_t nSection) {
+    if (store.hdr.nBranch == nBranch && store.hdr.nSection == nSection) return 1;
+    return walWrite(WAL_STUDENTS, store.fd, &store.hdr, sizeof(store.hdr), 0);
+}
+
+/* Append len encoded bytes to the heap; returns their offset or -1. */
+off_t storeHeapAppend(const unsigned char *buf, size_t len) {
+    off_t off = store.heapEnd;
+    if (!storeMap((size_t)off + len) || !walWrite(WAL_STUDENTS, store.fd, buf, len, off))
+        return -1;
+    store.heapEnd += (off_t)len;
+    return off;
+}
+
+int storeWrite(long rec, const Student *s) {
+    unsigned char buf[REC_MAX];
+    uint32_t nBranch = store.hdr.nBranch, nSection = store.hdr.nSection;
+    size_t len = recEncode(s, &store.hdr, buf);
+    if (!storeSaveHeader(nBranch, nSection)) return 0;
+
+    uint64_t old = store.slots[rec];
+    off_t off = slotOffset(old);
+    if (len <= slotLen(old)) {
+        if (!walWrite(WAL_STUDENTS, store.fd, buf, len, off)) return 0;
+    } else if ((off = storeHeapAppend(buf, len)) < 0) {
+        return 0;
+    }
+    uint64_t slot = slotMake(off, len);
+    if (slot != old && !storeWriteSlot(rec, slot)) return 0;
+    if (!walFinish()) return 0;
+
+    if (store.garbage >= 0)
+        store.garbage += (int64_t)slotLen(old) - (off == slotOffset(old) ? (int64_t)len : 0);
+    if (slotLen(old) == 0) store.dead = -1;
+    store.rows[rec] = *s;
+    store.decoded[rec] = 1;
+    storeGeneration++;
+    return 1;
+}
+
+/* Append n records with one heap write and one slot write; returns the
+   record number of the first one or -1. */
+long storeAppendBatch(const Student *recs, long n) {
+    if (!storeOpen(1)) return -1;
+    long first = store.count;
+    unsigned char *buf = (unsigned char *)malloc((size_t)n * REC_MAX + 1);
+    uint64_t *slots = (uint64_t *)malloc(sizeof(uint64_t) * (n + 1));
+    if (!buf || !slots || !storeReserve(first + n)) {
+        free(buf);
+        free(slots);
+        return -1;
+    }
+
+    uint32_t nBranch = store.hdr.nBranch, nSection = store.hdr.nSection;
+    size_t used = 0;
+    for (long i = 0; i < n; i++) {
+        size_t len = recEncode(&recs[i], &store.hdr, buf + used);
+        slots[i] = slotMake(store.heapEnd + (off_t)used, len);
+        used += len;
+    }
+    int ok = storeSaveHeader(nBranch, nSection) && storeHeapAppend(buf, used) >= 0 &&
+             walWrite(WAL_SLOTS, store.slotFd, slots, sizeof(uint64_t) * n, slotPos(first)) &&
+             walFinish();
+    if (ok) {
+        memcpy(store.slots + first, slots, sizeof(uint64_t) * n);
+        memcpy(store.rows + first, recs, sizeof(Student) * n);
+        memset(store.decoded + first, 1, (size_t)n);
+        store.count += n;
+    }
+    free(buf);
+    free(slots);
+    return ok ? first : -1;
+}
+
+long storeAppend(const Student *s) {
+    return storeAppendBatch(s, 1);
+}
+
+/*
+ * Replace the store with the given records, in order. The log is
+ * checkpointed first, because its offsets refer to the old files.
+ */
+int storeRewrite(const Student *const *recs, long n) {
+    if (!walCheckpoint() || !storeWriteFiles(recs, n)) return 0;
+    storeClose();
+    return storeOpen(0);
+}
+
+long storeDeadCount() {
+    if (store.dead < 0) {
+        store.dead = 0;
+        for (long i = 0; i < store.count; i++)
+            if (slotLen(store.slots[i]) == 0) store.dead++;
+    }
+    return store.dead;
+}
+
+int64_t storeGarbage() {
+    if (store.garbage < 0) {
+        int64_t used = 0;
+        for (long i = 0; i < store.count; i++) used += (int64_t)slotLen(store.slots[i]);
+        store.garbage = (int64_t)(store.heapEnd - STORE_HEAP_START) - used;
+    }
+    return store.garbage;
+}
+
+/* Turn a record into a tombstone. */
+int storeKill(long rec) {
+    long deadBefore = storeDeadCount();
+    int64_t garbageBefore = storeGarbage();
+    size_t len = slotLen(store.slots[rec]);
+    if (!storeWriteSlot(rec, 0) || !walFinish()) return 0;
+    memset(&store.rows[rec], 0, sizeof(Student));
+    store.decoded[rec] = 1;
+    store.dead = deadBefore + (len > 0);
+    store.garbage = garbageBefore + (int64_t)len;
+    storeGeneration++;
+    return 1;
+}
+
+int storeNeedsCompaction() {
+    long dead = storeDeadCount();
+    int64_t garbage = storeGarbage();
+    return (dead >= COMPACT_MIN_DEAD &&
+            dead >= (long)(COMPACT_DEAD_RATIO * (double)store.count)) ||
+           (garbage >= COMPACT_MIN_GARBAGE &&
+            garbage >= (int64_t)(COMPACT_DEAD_RATIO * (double)(store.heapEnd - STORE_HEAP_START)));
+}
+
+/* Rewrite the store without tombstones or unused heap bytes. Returns
+   records reclaimed, or -1 on error; *rewritten says whether the files
+   (and so the record numbers) changed. */
+long storeCompact(int *rewritten) {
+    long dead = storeDeadCount();
+    *rewritten = 0;
+    if (dead == 0 && storeGarbage() == 0) return 0;
+
+    const Student **live = (const Student **)malloc(sizeof(*live) * (store.count + 1));
+    if (!live) return -1;
+    long n = 0;
+    for (long i = 0; i < store.count; i++)
+        if (isLive(storeGet(i))) live[n++] = storeGet(i);
+
+    int ok = storeRewrite(live, n);
+    free(live);
+    if (!ok) return -1;
+    *rewritten = 1;
+    return dead;
+}
+
+/* ---------- DERIVED INDEXES ---------- */
+
+/*
+ * The ID index, the sorted indexes, the trigram index, the stats block
+ * and the column store are rebuilt from students.dat whenever they cannot
+ * be trusted, and share the life cycle kept here. Each file starts with a DerivedStamp naming the size
+ * and mtime of the students.dat it matches; any other stamp means the
+ * file is stale. The owner supplies callbacks that rebuild the contents
+ * from the store and read or write the body after the stamp.
+ *
+ * Writes are applied in memory and leave the index dirty: 1 when only
+ * the stamp moved because the write did not touch its fields, 2 when the
+ * contents changed. derivedFlush() then rewrites just the stamp in place,
+ * or the whole file. An index whose rebuild fails stays unavailable
+ * until students.dat changes again.
+ */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t  dataSize;
+    int64_t  dataMtime;
+} DerivedStamp;
+
+typedef struct DerivedIndex DerivedIndex;
+
+struct DerivedIndex {
+    const char *path;
+    uint32_t magic, version;
+    int  (*rebuild)(DerivedIndex *d);           /* fill from the store */
+    int  (*load)(DerivedIndex *d, FILE *fp);    /* read the body after the stamp */
+    void (*save)(DerivedIndex *d, FILE *fp);    /* write the body after the stamp */
+    int64_t dataSize, dataMtime;
+    int loaded;
+    int failed;             /* rebuild failed for this stamp */
+    int dirty;              /* 0 clean, 1 stamp only, 2 contents */
+};
+
+void derivedSave(DerivedIndex *d) {
+    DerivedStamp h = { d->magic, d->version, d->dataSize, d->dataMtime };
+
+    if (d->dirty == 1) {
+        int fd = open(d->path, O_WRONLY);
+        if (fd >= 0) {
+            ssize_t w = pwrite(fd, &h, sizeof(h), 0);
+            close(fd);
+            if (w == (ssize_t)sizeof(h)) {
+                d->dirty = 0;
+                return;
+            }
+        }
+    }
+
+    FILE *fp = fopen(d->path, "wb");
+    if (!fp) return;
+    fwrite(&h, sizeof(h), 1, fp);
+    d->save(d, fp);
+    if (fclose(fp) == 0) d->dirty = 0;
+}
+
+/* Drop d until students.dat changes, e.g. after a dictionary overflow. */
+void derivedFail(DerivedIndex *d) {
+    d->loaded = 0;
+    d->failed = 1;
+    d->dirty = 0;
+    storeStamp(&d->dataSize, &d->dataMtime);
+    remove(d->path);
+}
+
+int derivedRebuild(DerivedIndex *d) {
+    if (!d->rebuild(d)) {
+        derivedFail(d);
+        return 0;
+    }
+    storeStamp(&d->dataSize, &d->dataMtime);
+    d->loaded = 1;
+    d->failed = 0;
+    d->dirty = 2;
+    derivedSave(d);
+    return 1;
+}
+
+int derivedLoad(DerivedIndex *d) {
+    DerivedStamp h;
+    int64_t size, mtime;
+    FILE *fp = fopen(d->path, "rb");
+    if (!fp) return 0;
+
+    storeStamp(&size, &mtime);
+    int ok = fread(&h, sizeof(h), 1, fp) == 1 &&
+             h.magic == d->magic && h.version == d->version &&
+             h.dataSize == size && h.dataMtime == mtime &&
+             d->load(d, fp);
+    fclose(fp);
+    if (!ok) return 0;
+
+    d->dataSize = size;
+    d->dataMtime = mtime;
+    d->loaded = 1;
+    d->failed = 0;
+    d->dirty = 0;
+    return 1;
+}
+
+/* Make sure d matches students.dat; call before writing to the store.
+   Returns 0 if the index is unavailable. */
+int derivedEnsure(DerivedIndex *d) {
+    if (!storeOpen(0)) {
+        d->loaded = 0;
+        return 0;
+    }
+    if (d->loaded && soleWriter) return 1;
+    if (d->loaded || d->failed) {
+        int64_t size, mtime;
+        storeStamp(&size, &mtime);
+        if (size == d->dataSize && mtime == d->dataMtime) return d->loaded;
+        d->loaded = 0;
+        d->failed = 0;
+    }
+    return derivedLoad(d) || derivedRebuild(d);
+}
+
+/* Note a store write that changed d's contents, or only moved its stamp. */
+void derivedTouch(DerivedIndex *d, int changed) {
+    if (changed) d->dirty = 2;
+    else if (d->dirty == 0) d->dirty = 1;
+    storeStamp(&d->dataSize, &d->dataMtime);
+}
+
+void derivedInvalidate(DerivedIndex *d) {
+    d->loaded = 0;
+    d->failed = 0;
+    d->dirty = 0;
+    remove(d->path);
+}
+
+void derivedFlush(DerivedIndex *d) {
+    if (d->loaded && d->dirty) derivedSave(d);
+}
+
+/* ---------- ID HASH INDEX ---------- */
+
+/*
+ * students.idx maps a student ID to its record number in students.dat,
+ * so an ID lookup is one probe in memory plus decoding one record. The
+ * table uses open addressing with linear probing. It is a derived index,
+ * rebuilt from scratch when its stamp no longer matches students.dat.
+ * Adds and deletes write their slot in place as they happen.
+ */
+
+#define IDX_MAGIC   0x58444953u   /* "SIDX" */
+#define IDX_VERSION 2u
+#define IDX_EMPTY   (-1)
+#define IDX_DELETED (-2)
+
+typedef struct {
+    uint32_t capacity;      /* number of slots, power of two */
+    uint32_t used;          /* live + deleted slots */
+} IdxHeader;
+
+typedef struct {
+    uint64_t hash;
+    int64_t  rec;           /* record number, or IDX_EMPTY / IDX_DELETED */
+} IdxSlot;
+
+static IdxHeader idxHdr;
+static IdxSlot  *idxSlots = NULL;
+
+uint64_t hashId(const char *id) {
+    uint64_t h = 1469598103934665603ULL;        /* FNV-1a */
+    while (*id) {
+        h ^= (unsigned char)*id++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Returns 1 if index slot i points at a record with this ID. */
+int idxSlotMatches(uint32_t i, const char *id) {
+    long rec = (long)idxSlots[i].rec;
+    return rec < storeCount() && strcmp(storeGet(rec)->id, id) == 0;
+}
+
+/* Returns the slot holding ID id, or the first free slot if absent. The
+   slot only stores the hash, so a hash match counts once the record it
+   points at has the same ID; colliding IDs each get their own slot.
+   *found is 1 for a match, 0 if absent, and -1 if absent but a slot with
+   the same hash pointed at another ID (a collision, or a stale index). */
+uint32_t idxProbe(const char *id, int *found) {
+    uint64_t h = hashId(id);
+    uint32_t mask = idxHdr.capacity - 1;
+    uint32_t i = (uint32_t)h & mask;
+    uint32_t firstFree = UINT32_MAX;
+
+    *found = 0;
+    while (idxSlots[i].rec != IDX_EMPTY) {
+        if (idxSlots[i].rec == IDX_DELETED) {
+            if (firstFree == UINT32_MAX) firstFree = i;
+        } else if (idxSlots[i].hash == h) {
+            if (idxSlotMatches(i, id)) {
+                *found = 1;
+                return i;
+            }
+            *found = -1;
+        }
+        i = (i + 1) & mask;
+    }
+    return firstFree != UINT32_MAX ? firstFree : i;
+}
+
+int idxAlloc(uint32_t capacity) {
+    IdxSlot *slots = (IdxSlot *)malloc(sizeof(IdxSlot) * capacity);
+    if (!slots) return 0;
+    for (uint32_t i = 0; i < capacity; i++) {
+        slots[i].hash = 0;
+        slots[i].rec  = IDX_EMPTY;
+    }
+    free(idxSlots);
+    idxSlots = slots;
+    idxHdr.capacity = capacity;
+    idxHdr.used     = 0;
+    return 1;
+}
+
+/* Scan students.dat once. The first record with a given ID wins,
+   matching what the old linear scans returned. */
+int idxRebuild(DerivedIndex *d) {
+    long n = storeCount();
+    (void)d;
+
+    uint32_t capacity = 64;
+    while (capacity < (uint32_t)n * 2) capacity <<= 1;
+    if (!idxAlloc(capacity)) return 0;
+
+    for (long rec = 0; rec < n; rec++) {
+        const Student *s = storeGet(rec);
+        if (!isLive(s)) continue;
+        int found;
+        uint32_t i = idxProbe(s->id, &found);
+        if (found > 0) continue;
+        idxSlots[i].hash = hashId(s->id);
+        idxSlots[i].rec  = rec;
+        idxHdr.used++;
+    }
+    return 1;
+}
+
+int idxLoad(DerivedIndex *d, FILE *fp) {
+    IdxHeader h;
+    (void)d;
+    if (fread(&h, sizeof(h), 1, fp) != 1 ||
+        h.capacity < 64 || (h.capacity & (h.capacity - 1)) != 0 || h.used > h.capacity ||
+        !idxAlloc(h.capacity) ||
+        fread(idxSlots, sizeof(IdxSlot), h.capacity, fp) != h.capacity)
+        return 0;
+    idxHdr = h;
+    return 1;
+}
+
+void idxSave(DerivedIndex *d, FILE *fp) {
+    (void)d;
+    fwrite(&idxHdr, sizeof(idxHdr), 1, fp);
+    fwrite(idxSlots, sizeof(IdxSlot), idxHdr.capacity, fp);
+}
+
+static DerivedIndex idIndex = { IDX_FILE, IDX_MAGIC, IDX_VERSION, idxRebuild, idxLoad, idxSave,
+                                0, 0, 0, 0, 0 };
+
+/* Write slot i and the header in place, so that a flush only has to
+   restamp the file instead of rewriting every slot. */
+void idxSaveSlot(uint32_t i) {
+    int fd = open(IDX_FILE, O_WRONLY);
+    int ok = fd >= 0 &&
+             pwriteAll(fd, &idxHdr, sizeof(idxHdr), (off_t)sizeof(DerivedStamp)) &&
+             pwriteAll(fd, &idxSlots[i], sizeof(IdxSlot),
+                       (off_t)(sizeof(DerivedStamp) + sizeof(idxHdr) + i * sizeof(IdxSlot)));
+    if (fd >= 0) close(fd);
+    derivedTouch(&idIndex, !ok);
+}
+
+void idxInsert(const char *id, long rec) {
+    if ((idxHdr.used + 1) * 2 > idxHdr.capacity) {
+        derivedRebuild(&idIndex);
+        return;
+    }
+    int found;
+    uint32_t i = idxProbe(id, &found);
+    if (found > 0) return;
+    if (idxSlots[i].rec == IDX_EMPTY) idxHdr.used++;
+    idxSlots[i].hash = hashId(id);
+    idxSlots[i].rec  = rec;
+    idxSaveSlot(i);
+}
+
+/* Drop the entry for record rec, which held ID id. The record has
+   usually been overwritten already, so match on the record number. */
+void idxRemove(const char *id, long rec) {
+    uint64_t h = hashId(id);
+    uint32_t mask = idxHdr.capacity - 1;
+    for (uint32_t i = (uint32_t)h & mask; idxSlots[i].rec != IDX_EMPTY; i = (i + 1) & mask) {
+        if (idxSlots[i].hash == h && idxSlots[i].rec == rec) {
+            idxSlots[i].rec = IDX_DELETED;
+            idxSaveSlot(i);
+            return;
+        }
+    }
+}
+
+/* Apply a write to record rec, which may be one past the end (an append). */
+void idxApply(long rec, const Student *old, const Student *cur) {
+    if (!idIndex.loaded) return;
+    if (old && cur && strcmp(old->id, cur->id) == 0) {
+        derivedTouch(&idIndex, 0);
+        return;
+    }
+    if (old && isLive(old)) idxRemove(old->id, rec);
+    if (cur && isLive(cur)) idxInsert(cur->id, rec);
+}
+
+/* Probe the loaded index without re-validating it against the data file.
+   Used by bulk import, whose own appends do not affect existing entries. */
+int idxHas(const char *id) {
+    int found;
+    if (!idIndex.loaded) return 0;
+    idxProbe(id, &found);
+    return found > 0;
+}
+
+/* Look up a student by ID. Returns a view of the record (and its record
+   number if rec is given), or NULL. */
+const Student *lookupStudent(const char *id, long *rec) {
+    if (!storeOpen(0) || !derivedEnsure(&idIndex)) return NULL;
+    int found;
+    uint32_t i = idxProbe(id, &found);
+    if (found < 0 && !soleWriter) {
+        /* The index may disagree with the data file: rebuild and retry once. */
+        if (!derivedRebuild(&idIndex)) return NULL;
+        i = idxProbe(id, &found);
+    }
+    if (found <= 0) return NULL;
+    if (rec) *rec = (long)idxSlots[i].rec;
+    return storeGet((long)idxSlots[i].rec);
+}
+
+/* Same as lookupStudent, but copies the record so the caller can edit it. */
+int findStudent(const char *id, Student *s, long *rec) {
+    const Student *v = lookupStudent(id, rec);
+    if (!v) return 0;
+    *s = *v;
+    return 1;
+}
+
+/* ---------- SORTED INDEXES ---------- */
+
+/*
+ * students.cgpa.idx and students.name.idx list the record numbers of all
+ * live students, ordered by (CGPA, name) and by name. Ties are broken by
+ * record number, so every entry has a unique position. Writes keep the
+ * arrays ordered with a binary search and a memmove. Sorted listings,
+ * top-K and range queries are answered from them without reordering
+ * students.dat.
+ *
+ * Both are derived indexes: changes are kept in memory and written back
+ * at the end of a session, and an index that missed a write (for example
+ * after a crash) is rebuilt on next use.
+ */
+
+#define SORT_MAGIC   0x54524F53u   /* "SORT" */
+#define SORT_VERSION 3u
+
+/* After the stamp: int64 count, then count record numbers. */
+typedef struct {
+    DerivedIndex di;        /* first, so the callbacks can cast back */
+    int (*cmp)(const Student *, const Student *);
+    int32_t *recs;
+    long count, cap;
+} SortIndex;
+
+int keyCgpa(const Student *a, const Student *b) {
+    float x = cgpaClamp(a->cgpa), y = cgpaClamp(b->cgpa);
+    if (x < y) return -1;
+    if (x > y) return 1;
+    return strcmp(a->name, b->name);
+}
+
+int keyName(const Student *a, const Student *b) {
+    return strcmp(a->name, b->name);
+}
+
+static const SortIndex *sortingIndex;   /* qsort has no context argument */
+
+int cmpSortEntry(const void *a, const void *b) {
+    int32_t ra = *(const int32_t *)a, rb = *(const int32_t *)b;
+    int c = sortingIndex->cmp(storeGet(ra), storeGet(rb));
+    if (c != 0) return c;
+    return (ra > rb) - (ra < rb);
+}
+
+int sortIdxReserve(SortIndex *ix, long count) {
+    if (count <= ix->cap) return 1;
+    long cap = ix->cap ? ix->cap : 1024;
+    while (cap < count) cap *= 2;
+    int32_t *recs = (int32_t *)realloc(ix->recs, sizeof(int32_t) * cap);
+    if (!recs) return 0;
+    ix->recs = recs;
+    ix->cap = cap;
+    return 1;
+}
+
+void sortIdxSave(DerivedIndex *d, FILE *fp) {
+    const SortIndex *ix = (const SortIndex *)d;
+    int64_t count = ix->count;
+    fwrite(&count, sizeof(count), 1, fp);
+    if (ix->count > 0) fwrite(ix->recs, sizeof(int32_t), ix->count, fp);
+}
+
+int sortIdxRebuild(DerivedIndex *d) {
+    SortIndex *ix = (SortIndex *)d;
+    long n = storeCount();
+    ix->count = 0;
+    if (!sortIdxReserve(ix, n)) return 0;
+    for (long i = 0; i < n; i++)
+        if (isLive(storeGet(i))) ix->recs[ix->count++] = (int32_t)i;
+
+    sortingIndex = ix;
+    if (ix->count > 0) qsort(ix->recs, ix->count, sizeof(int32_t), cmpSortEntry);
+    return 1;
+}
+
+int sortIdxLoad(DerivedIndex *d, FILE *fp) {
+    SortIndex *ix = (SortIndex *)d;
+    int64_t count;
+    if (fread(&count, sizeof(count), 1, fp) != 1 || count < 0 || count > storeCount() ||
+        !sortIdxReserve(ix, (long)count) ||
+        (count > 0 && fread(ix->recs, sizeof(int32_t), (size_t)count, fp) != (size_t)count))
+        return 0;
+    ix->count = (long)count;
+    return 1;
+}
+
+#define SORT_INDEX(path, cmp) \
+    { { path, SORT_MAGIC, SORT_VERSION, sortIdxRebuild, sortIdxLoad, sortIdxSave, 0, 0, 0, 0, 0 }, \
+      cmp, NULL, 0, 0 }
+
+static SortIndex cgpaIndex = SORT_INDEX("students.cgpa.idx", keyCgpa);
+static SortIndex nameIndex = SORT_INDEX("students.name.idx", keyName);
+static SortIndex *const sortIndexes[] = { &cgpaIndex, &nameIndex };
+#define SORT_INDEX_COUNT (sizeof(sortIndexes) / sizeof(sortIndexes[0]))
+
+/*
+ * First position whose entry orders at or after (s, rec). The entry for
+ * rec itself compares equal without looking at the store, because the
+ * store may already hold the record's new contents.
+ */
+long sortIdxLowerBound(const SortIndex *ix, const Student *s, long rec) {
+    long lo = 0, hi = ix->count;
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        int32_t r = ix->recs[mid];
+        int c = 0;
+        if (r != rec) {
+            c = ix->cmp(storeGet(r), s);
+            if (c == 0) c = (r > rec) - (r < rec);
+        }
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void sortIdxRemove(SortIndex *ix, const Student *old, long rec) {
+    long pos = sortIdxLowerBound(ix, old, rec);
+    if (pos >= ix->count || ix->recs[pos] != rec) {
+        ix->di.loaded = 0;          /* out of step; rebuild on next use */
+        return;
+    }
+    memmove(&ix->recs[pos], &ix->recs[pos + 1], sizeof(int32_t) * (ix->count - pos - 1));
+    ix->count--;
+}
+
+void sortIdxInsert(SortIndex *ix, const Student *cur, long rec) {
+    if (!sortIdxReserve(ix, ix->count + 1)) {
+        ix->di.loaded = 0;
+        return;
+    }
+    long pos = sortIdxLowerBound(ix, cur, rec);
+    memmove(&ix->recs[pos + 1], &ix->recs[pos], sizeof(int32_t) * (ix->count - pos));
+    ix->recs[pos] = (int32_t)rec;
+    ix->count++;
+}
+
+/* Apply a write to record rec; old or cur is NULL for an insert or a delete. */
+void sortIdxApply(SortIndex *ix, long rec, const Student *old, const Student *cur) {
+    if (!ix->di.loaded) return;
+    if (old && !isLive(old)) old = NULL;
+    if (cur && !isLive(cur)) cur = NULL;
+
+    int changed = !old || !cur || ix->cmp(old, cur) != 0;
+    if (changed) {
+        if (old) sortIdxRemove(ix, old, rec);
+        if (cur && ix->di.loaded) sortIdxInsert(ix, cur, rec);
+    }
+    derivedTouch(&ix->di, changed);
+}
+
+/* First position in the CGPA index whose CGPA is >= cgpa. */
+long cgpaLowerBound(float cgpa) {
+    long lo = 0, hi = cgpaIndex.count;
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (cgpaClamp(storeGet(cgpaIndex.recs[mid])->cgpa) < cgpa) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* ---------- TRIGRAM INDEX ---------- */
+
+/*
+ * students.tri maps every three-character sequence that occurs in a
+ * student name, case-folded, to the ascending list of record numbers
+ * whose name contains it. A substring query looks up the lists for its
+ * own trigrams, intersects them starting from the shortest and checks
+ * the few remaining names. Each name also contributes a start-anchored
+ * trigram (TRI_START plus its first two characters), which turns a
+ * prefix query into the same kind of lookup.
+ *
+ * Queries too short to have a trigram fall back to a scan. The index is
+ * maintained by every write, written back at the end of the session and
+ * stamped against students.dat like the other indexes.
+ */
+
+#define TRI_FILE    "students.tri"
+#define TRI_MAGIC   0x49525453u   /* "STRI" */
+#define TRI_VERSION 2u
+#define TRI_START   0x01          /* marks the start of a name */
+#define TRI_EMPTY   0xFFFFFFFFu
+#define TRI_MAX     64            /* trigrams per name, with room to spare */
+
+/* Follows the stamp. */
+typedef struct {
+    int64_t  lists;
+    int64_t  postings;
+} TriHeader;
+
+typedef struct {
+    uint32_t tri;
+    int32_t  count, cap;
+    int32_t *recs;
+} TriList;
+
+typedef struct {
+    TriList *slots;
+    uint32_t capacity, used;
+} TrigramIndex;
+
+static TrigramIndex tri;
+
+uint32_t triKey(unsigned char a, unsigned char b, unsigned char c) {
+    return (uint32_t)tolower(a) << 16 | (uint32_t)tolower(b) << 8 | (uint32_t)tolower(c);
+}
+
+int cmpU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Distinct trigrams of text, plus the start trigram when anchored is set.
+   Returns how many were written to out. */
+int triExtract(const char *text, int anchored, uint32_t *out) {
+    const unsigned char *p = (const unsigned char *)text;
+    size_t len = strlen(text);
+    int n = 0;
+    if (anchored && len >= 2) out[n++] = triKey(TRI_START, p[0], p[1]);
+    for (size_t i = 0; i + 3 <= len && n < TRI_MAX; i++)
+        out[n++] = triKey(p[i], p[i + 1], p[i + 2]);
+
+    qsort(out, n, sizeof(uint32_t), cmpU32);
+    int u = 0;
+    for (int i = 0; i < n; i++)
+        if (u == 0 || out[u - 1] != out[i]) out[u++] = out[i];
+    return u;
+}
+
+void triFree() {
+    for (uint32_t i = 0; i < tri.capacity; i++) free(tri.slots[i].recs);
+    free(tri.slots);
+    tri.slots = NULL;
+    tri.capacity = tri.used = 0;
+}
+
+TriList *triAllocSlots(uint32_t capacity) {
+    TriList *slots = (TriList *)calloc(capacity, sizeof(TriList));
+    if (slots)
+        for (uint32_t i = 0; i < capacity; i++) slots[i].tri = TRI_EMPTY;
+    return slots;
+}
+
+/* Start an empty table. */
+int triReset(uint32_t capacity) {
+    triFree();
+    tri.slots = triAllocSlots(capacity);
+    if (!tri.slots) return 0;
+    tri.capacity = capacity;
+    return 1;
+}
+
+/* The list for key, or NULL; with create set, an empty list is added. */
+TriList *triList(uint32_t key, int create) {
+    if (tri.capacity == 0) return NULL;
+    uint32_t mask = tri.capacity - 1;
+    uint32_t i = (key * 2654435761u) & mask;
+    while (tri.slots[i].tri != TRI_EMPTY) {
+        if (tri.slots[i].tri == key) return &tri.slots[i];
+        i = (i + 1) & mask;
+    }
+    if (!create) return NULL;
+
+    if ((tri.used + 1) * 2 > tri.capacity) {
+        uint32_t cap = tri.capacity * 2;
+        TriList *slots = triAllocSlots(cap);
+        if (!slots) return NULL;
+        for (uint32_t j = 0; j < tri.capacity; j++) {
+            if (tri.slots[j].tri == TRI_EMPTY) continue;
+            uint32_t k = (tri.slots[j].tri * 2654435761u) & (cap - 1);
+            while (slots[k].tri != TRI_EMPTY) k = (k + 1) & (cap - 1);
+            slots[k] = tri.slots[j];
+        }
+        free(tri.slots);
+        tri.slots = slots;
+        tri.capacity = cap;
+        return triList(key, 1);
+    }
+    tri.slots[i].tri = key;
+    tri.used++;
+    return &tri.slots[i];
+}
+
+/* First position in l whose record number is >= rec, starting at from. */
+int32_t triLowerBound(const TriList *l, int32_t from, int32_t rec) {
+    int32_t lo = from, hi = l->count;
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (l->recs[mid] < rec) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int triAdd(uint32_t key, int32_t rec) {
+    TriList *l = triList(key, 1);
+    if (!l) return 0;
+    if (l->count == l->cap) {
+        int32_t cap = l->cap ? l->cap * 2 : 4;
+        int32_t *recs = (int32_t *)realloc(l->recs, sizeof(int32_t) * cap);
+        if (!recs) return 0;
+        l->recs = recs;
+        l->cap = cap;
+    }
+    int32_t pos = l->count > 0 && l->recs[l->count - 1] < rec ? l->count
+                                                              : triLowerBound(l, 0, rec);
+    memmove(&l->recs[pos + 1], &l->recs[pos], sizeof(int32_t) * (l->count - pos));
+    l->recs[pos] = rec;
+    l->count++;
+    return 1;
+}
+
+void triRemove(uint32_t key, int32_t rec) {
+    TriList *l = triList(key, 0);
+    if (!l) return;
+    int32_t pos = triLowerBound(l, 0, rec);
+    if (pos >= l->count || l->recs[pos] != rec) return;
+    memmove(&l->recs[pos], &l->recs[pos + 1], sizeof(int32_t) * (l->count - pos - 1));
+    l->count--;
+}
+
+/* Add (sign = 1) or remove (sign = -1) one name's trigrams for rec. */
+int triAccount(const char *name, long rec, int sign) {
+    uint32_t keys[TRI_MAX];
+    int n = triExtract(name, 1, keys);
+    for (int i = 0; i < n; i++) {
+        if (sign < 0) triRemove(keys[i], (int32_t)rec);
+        else if (!triAdd(keys[i], (int32_t)rec)) return 0;
+    }
+    return 1;
+}
+
+void triSave(DerivedIndex *d, FILE *fp) {
+    TriHeader h = { 0, 0 };
+    (void)d;
+    for (uint32_t i = 0; i < tri.capacity; i++) {
+        if (tri.slots[i].tri == TRI_EMPTY || tri.slots[i].count == 0) continue;
+        h.lists++;
+        h.postings += tri.slots[i].count;
+    }
+
+    /* Counts, then (trigram, count) pairs, then the lists in that order. */
+    fwrite(&h, sizeof(h), 1, fp);
+    for (uint32_t i = 0; i < tri.capacity; i++) {
+        const TriList *l = &tri.slots[i];
+        if (l->tri == TRI_EMPTY || l->count == 0) continue;
+        uint32_t pair[2] = { l->tri, (uint32_t)l->count };
+        fwrite(pair, sizeof(pair), 1, fp);
+    }
+    for (uint32_t i = 0; i < tri.capacity; i++) {
+        const TriList *l = &tri.slots[i];
+        if (l->tri == TRI_EMPTY || l->count == 0) continue;
+        fwrite(l->recs, sizeof(int32_t), l->count, fp);
+    }
+}
+
+int triRebuild(DerivedIndex *d) {
+    (void)d;
+    if (!triReset(4096)) return 0;
+    for (long i = 0; i < storeCount(); i++) {
+        const Student *s = storeGet(i);
+        if (isLive(s) && !triAccount(s->name, i, 1)) return 0;
+    }
+    return 1;
+}
+
+int triLoad(DerivedIndex *d, FILE *fp) {
+    TriHeader h;
+    uint32_t (*pairs)[2] = NULL;
+    (void)d;
+
+    int ok = fread(&h, sizeof(h), 1, fp) == 1 &&
+             h.lists >= 0 && h.lists < (1 << 24) && h.postings >= 0;
+    if (ok) {
+        uint32_t cap = 4096;
+        while ((int64_t)cap < h.lists * 2 + 2) cap *= 2;
+        pairs = (uint32_t (*)[2])malloc(sizeof(*pairs) * (size_t)(h.lists + 1));
+        ok = pairs && triReset(cap) &&
+             fread(pairs, sizeof(*pairs), (size_t)h.lists, fp) == (size_t)h.lists;
+        for (int64_t i = 0; ok && i < h.lists; i++) {
+            TriList *l = triList(pairs[i][0], 1);
+            int32_t n = (int32_t)pairs[i][1];
+            ok = l && n > 0 && (l->recs = (int32_t *)malloc(sizeof(int32_t) * n)) != NULL &&
+                 fread(l->recs, sizeof(int32_t), n, fp) == (size_t)n;
+            if (ok) l->count = l->cap = n;
+        }
+    }
+    free(pairs);
+    if (!ok) triFree();
+    return ok;
+}
+
+static DerivedIndex triIndex = { TRI_FILE, TRI_MAGIC, TRI_VERSION, triRebuild, triLoad, triSave,
+                                 0, 0, 0, 0, 0 };
+
+void triApply(long rec, const Student *old, const Student *cur) {
+    if (!triIndex.loaded) return;
+    if (old && !isLive(old)) old = NULL;
+    if (cur && !isLive(cur)) cur = NULL;
+
+    int changed = !old || !cur || strcmp(old->name, cur->name) != 0;
+    if (changed) {
+        if (old) triAccount(old->name, rec, -1);
+        if (cur && !triAccount(cur->name, rec, 1)) triIndex.loaded = 0;
+    }
+    derivedTouch(&triIndex, changed);
+}
+
+int nameMatches(const char *name, const char *q, int prefix) {
+    size_t qn = strlen(q);
+    if (qn == 0) return 1;
+    int first = tolower((unsigned char)q[0]);
+    for (const char *p = name; *p; p++) {
+        if (tolower((unsigned char)*p) == first && strncasecmp(p, q, qn) == 0) return 1;
+        if (prefix) break;
+    }
+    return 0;
+}
+
+/*
+ * Record numbers of live students whose name starts with (prefix set) or
+ * contains q, in record order. Returns the count, or -1; *out must be
+ * freed by the caller.
+ */
+long triSearch(const char *q, int prefix, int32_t **out) {
+    uint32_t keys[TRI_MAX];
+    const TriList *lists[TRI_MAX];
+    int n = triExtract(q, prefix, keys);
+    long hits = 0;
+
+    *out = NULL;
+    if (n == 0 || !derivedEnsure(&triIndex)) {
+        /* Nothing to look up: check every name. */
+        if (!storeOpen(0)) return 0;
+        *out = (int32_t *)malloc(sizeof(int32_t) * (storeCount() + 1));
+        if (!*out) return -1;
+        for (long i = 0; i < storeCount(); i++) {
+            const Student *s = storeGet(i);
+            if (isLive(s) && nameMatches(s->name, q, prefix)) (*out)[hits++] = (int32_t)i;
+        }
+        return hits;
+    }
+
+    for (int i = 0; i < n; i++) {
+        lists[i] = triList(keys[i], 0);
+        if (!lists[i] || lists[i]->count == 0) return 0;
+    }
+    for (int i = 1; i < n; i++) {           /* shortest list first */
+        const TriList *l = lists[i];
+        int j = i;
+        for (; j > 0 && lists[j - 1]->count > l->count; j--) lists[j] = lists[j - 1];
+        lists[j] = l;
+    }
+
+    int32_t at[TRI_MAX] = { 0 };        /* candidates ascend, so cursors only advance */
+    *out = (int32_t *)malloc(sizeof(int32_t) * (lists[0]->count + 1));
+    if (!*out) return -1;
+    for (int32_t k = 0; k < lists[0]->count; k++) {
+        int32_t rec = lists[0]->recs[k];
+        int keep = 1;
+        for (int i = 1; i < n && keep; i++) {
+            at[i] = triLowerBound(lists[i], at[i], rec);
+            keep = at[i] < lists[i]->count && lists[i]->recs[at[i]] == rec;
+        }
+        /* Trigrams can match out of order; confirm on the name itself. */
+        if (keep && nameMatches(storeGet(rec)->name, q, prefix)) (*out)[hits++] = rec;
+    }
+    return hits;
+}
+
+/* ---------- STATS BLOCK ---------- */
+
+/*
+ * students.stats holds running totals for the analytics dashboard, so it
+ * never rescans the store: the live count, the CGPA sum in fixed point
+ * (1e-4 units, exact and free of drift), a histogram with 0.01 buckets
+ * that yields min, max and percentiles, and per-branch and per-section
+ * count/sum tables. Every write adds and subtracts its record's share.
+ * The block is a derived index, written back at the end of a session.
+ */
+
+#define STATS_FILE     "students.stats"
+#define STATS_MAGIC    0x54415453u   /* "STAT" */
+#define STATS_VERSION  2u
+#define STATS_BUCKETS  1001           /* CGPA 0.00 .. 10.00 */
+#define CGPA_FIXED     10000.0
+
+typedef struct {
+    char key[20];
+    int64_t count;
+    int64_t sum;            /* CGPA in 1e-4 units */
+} StatsGroup;
+
+typedef struct {
+    StatsGroup *items;
+    uint32_t n, cap;
+} StatsGroups;
+
+typedef struct {
+    int64_t  count;
+    int64_t  sum;
+    uint32_t nBranch;
+    uint32_t nSection;
+} StatsHeader;
+
+static StatsHeader stats;
+static int64_t     statsHist[STATS_BUCKETS];
+static StatsGroups statsBranch, statsSection;
+
+/* Both take a clamped CGPA, so the conversions below cannot overflow. */
+int64_t cgpaFixed(float cgpa) {
+    return (int64_t)(cgpaClamp(cgpa) * CGPA_FIXED + 0.5);
+}
+
+int cgpaBucket(float cgpa) {
+    return (int)(cgpaClamp(cgpa) * 100.0f + 0.5f);
+}
+
+StatsGroup *statsGroup(StatsGroups *g, const char *key) {
+    for (uint32_t i = 0; i < g->n; i++)
+        if (strncmp(g->items[i].key, key, sizeof(g->items[i].key)) == 0)
+            return &g->items[i];
+
+    if (g->n == g->cap) {
+        uint32_t cap = g->cap ? g->cap * 2 : 16;
+        StatsGroup *items = (StatsGroup *)realloc(g->items, sizeof(StatsGroup) * cap);
+        if (!items) return NULL;
+        g->items = items;
+        g->cap = cap;
+    }
+    StatsGroup *grp = &g->items[g->n++];
+    memset(grp, 0, sizeof(*grp));
+    strncpy(grp->key, key, sizeof(grp->key) - 1);
+    return grp;
+}
+
+/* Add (sign = 1) or remove (sign = -1) one student's contribution. */
+void statsAccount(const Student *s, int sign) {
+    int64_t v = cgpaFixed(s->cgpa);
+    StatsGroup *g;
+
+    stats.count += sign;
+    stats.sum += sign * v;
+    statsHist[cgpaBucket(s->cgpa)] += sign;
+    if ((g = statsGroup(&statsBranch, s->branch))) {
+        g->count += sign;
+        g->sum += sign * v;
+    }
+    if ((g = statsGroup(&statsSection, s->section))) {
+        g->count += sign;
+        g->sum += sign * v;
+    }
+}
+
+void statsReset() {
+    memset(&stats, 0, sizeof(stats));
+    memset(statsHist, 0, sizeof(statsHist));
+    statsBranch.n = 0;
+    statsSection.n = 0;
+}
+
+void statsSave(DerivedIndex *d, FILE *fp) {
+    (void)d;
+    stats.nBranch = statsBranch.n;
+    stats.nSection = statsSection.n;
+    fwrite(&stats, sizeof(stats), 1, fp);
+    fwrite(statsHist, sizeof(int64_t), STATS_BUCKETS, fp);
+    if (statsBranch.n > 0) fwrite(statsBranch.items, sizeof(StatsGroup), statsBranch.n, fp);
+    if (statsSection.n > 0) fwrite(statsSection.items, sizeof(StatsGroup), statsSection.n, fp);
+}
+
+int statsRebuild(DerivedIndex *d) {
+    (void)d;
+    statsReset();
+    for (long i = 0; i < storeCount(); i++)
+        if (isLive(storeGet(i))) statsAccount(storeGet(i), 1);
+    return 1;
+}
+
+int statsReadGroups(FILE *fp, StatsGroups *g, uint32_t n) {
+    g->n = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        StatsGroup item;
+        if (fread(&item, sizeof(item), 1, fp) != 1) return 0;
+        item.key[sizeof(item.key) - 1] = '\0';
+        StatsGroup *dst = statsGroup(g, item.key);
+        if (!dst) return 0;
+        *dst = item;
+    }
+    return 1;
+}
+
+int statsLoad(DerivedIndex *d, FILE *fp) {
+    StatsHeader h;
+    (void)d;
+    statsReset();
+    if (fread(&h, sizeof(h), 1, fp) != 1 ||
+        fread(statsHist, sizeof(int64_t), STATS_BUCKETS, fp) != STATS_BUCKETS ||
+        !statsReadGroups(fp, &statsBranch, h.nBranch) ||
+        !statsReadGroups(fp, &statsSection, h.nSection))
+        return 0;
+    stats = h;
+    return 1;
+}
+
+static DerivedIndex statsIndex = { STATS_FILE, STATS_MAGIC, STATS_VERSION, statsRebuild, statsLoad,
+                                   statsSave, 0, 0, 0, 0, 0 };
+
+void statsApply(const Student *old, const Student *cur) {
+    if (!statsIndex.loaded) return;
+    if (old && isLive(old)) statsAccount(old, -1);
+    if (cur && isLive(cur)) statsAccount(cur, 1);
+    derivedTouch(&statsIndex, 1);
+}
+
+/* Smallest CGPA bucket value at or above the given fraction of students. */
+float statsPercentile(double p) {
+    int64_t rank = (int64_t)(p * (double)stats.count + 0.999999);
+    if (rank < 1) rank = 1;
+    int64_t seen = 0;
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+        seen += statsHist[b];
+        if (seen >= rank) return (float)b / 100.0f;
+    }
+    return 10.0f;
+}
+
+/* ---------- COLUMN STORE ---------- */
+
+/*
+ * students.col holds the fields that analytics scan, one column each and
+ * indexed by record number: CGPA as a float array, and branch and section
+ * as one-byte codes into small dictionaries. A scan reads 6 bytes per
+ * student instead of a whole record. Code 0 marks a deleted record, whose
+ * CGPA is stored as 0. If a dictionary would pass COL_MAX_CODES values the
+ * store is dropped and callers fall back to row scans.
+ *
+ * The columns follow every write like the sorted indexes: they are updated
+ * in memory, written back at the end of the session and stamped against
+ * students.dat.
+ */
+
+#define COL_FILE      "students.col"
+#define COL_MAGIC     0x4C4F4353u   /* "SCOL" */
+#define COL_VERSION   3u
+#define COL_MAX_CODES 255
+
+/* Follows the stamp. */
+typedef struct {
+    int64_t  count;
+    uint32_t nBranch;
+    uint32_t nSection;
+} ColHeader;
+
+typedef struct {
+    float   *cgpa;
+    uint8_t *branch;
+    uint8_t *section;
+    long count, cap;
+    char branchKeys[COL_MAX_CODES + 1][20];     /* code 0 is unused */
+    char sectionKeys[COL_MAX_CODES + 1][10];
+    uint32_t nBranch, nSection;                 /* codes in use, plus one */
+} ColumnStore;
+
+static ColumnStore cols;
+
+int colReserve(long count) {
+    if (count <= cols.cap) return 1;
+    long cap = cols.cap ? cols.cap : 1024;
+    while (cap < count) cap *= 2;
+    float *cgpa = (float *)realloc(cols.cgpa, sizeof(float) * cap);
+    if (cgpa) cols.cgpa = cgpa;
+    uint8_t *branch = (uint8_t *)realloc(cols.branch, cap);
+    if (branch) cols.branch = branch;
+    uint8_t *section = (uint8_t *)realloc(cols.section, cap);
+    if (section) cols.section = section;
+    if (!cgpa || !branch || !section) return 0;
+    cols.cap = cap;
+    return 1;
+}
+
+/* Store record rec (NULL or a tombstone clears it). Returns 0 on overflow. */
+int colSet(long rec, const Student *s) {
+    if (!s || !isLive(s)) {
+        cols.cgpa[rec] = 0.0f;
+        cols.branch[rec] = 0;
+        cols.section[rec] = 0;
+        return 1;
+    }
+    uint8_t b = dictCode(&cols.branchKeys[0][0], sizeof(cols.branchKeys[0]), &cols.nBranch, s->branch);
+    uint8_t c = dictCode(&cols.sectionKeys[0][0], sizeof(cols.sectionKeys[0]), &cols.nSection, s->section);
+    if (b == 0 || c == 0) return 0;
+    cols.cgpa[rec] = cgpaClamp(s->cgpa);
+    cols.branch[rec] = b;
+    cols.section[rec] = c;
+    return 1;
+}
+
+void colSave(DerivedIndex *d, FILE *fp) {
+    ColHeader h = { cols.count, cols.nBranch, cols.nSection };
+    (void)d;
+    fwrite(&h, sizeof(h), 1, fp);
+    fwrite(cols.branchKeys, sizeof(cols.branchKeys[0]), cols.nBranch, fp);
+    fwrite(cols.sectionKeys, sizeof(cols.sectionKeys[0]), cols.nSection, fp);
+    if (cols.count == 0) return;
+    fwrite(cols.cgpa, sizeof(float), cols.count, fp);
+    fwrite(cols.branch, 1, cols.count, fp);
+    fwrite(cols.section, 1, cols.count, fp);
+}
+
+/* Fails when a dictionary overflows; callers then fall back to row scans. */
+int colRebuild(DerivedIndex *d) {
+    long n = storeCount();
+    (void)d;
+    cols.count = 0;
+    cols.nBranch = cols.nSection = 1;
+    if (!colReserve(n)) return 0;
+    for (long i = 0; i < n; i++)
+        if (!colSet(i, storeGet(i))) return 0;
+    cols.count = n;
+    return 1;
+}
+
+int colLoad(DerivedIndex *d, FILE *fp) {
+    ColHeader h;
+    (void)d;
+    int ok = fread(&h, sizeof(h), 1, fp) == 1 &&
+             h.count == storeCount() &&
+             h.nBranch >= 1 && h.nBranch <= COL_MAX_CODES + 1 &&
+             h.nSection >= 1 && h.nSection <= COL_MAX_CODES + 1;
+    if (ok) {
+        size_t n = (size_t)h.count;
+        ok = colReserve((long)h.count) &&
+             fread(cols.branchKeys, sizeof(cols.branchKeys[0]), h.nBranch, fp) == h.nBranch &&
+             fread(cols.sectionKeys, sizeof(cols.sectionKeys[0]), h.nSection, fp) == h.nSection &&
+             (n == 0 || (fread(cols.cgpa, sizeof(float), n, fp) == n &&
+                         fread(cols.branch, 1, n, fp) == n &&
+                         fread(cols.section, 1, n, fp) == n));
+    }
+    if (!ok) return 0;
+
+    cols.count = (long)h.count;
+    cols.nBranch = h.nBranch;
+    cols.nSection = h.nSection;
+    return 1;
+}
+
+static DerivedIndex colIndex = { COL_FILE, COL_MAGIC, COL_VERSION, colRebuild, colLoad, colSave,
+                                 0, 0, 0, 0, 0 };
+
+/* Apply a write to record rec, which may be one past the end (an append). */
+void colApply(long rec, const Student *old, const Student *cur) {
+    if (!colIndex.loaded) return;
+    if (rec >= cols.count) {
+        if (!colReserve(rec + 1)) {
+            colIndex.loaded = 0;
+            return;
+        }
+        while (cols.count <= rec) colSet(cols.count++, NULL);
+    }
+    int same = old && cur && isLive(old) && isLive(cur) && old->cgpa == cur->cgpa &&
+               strcmp(old->branch, cur->branch) == 0 && strcmp(old->section, cur->section) == 0;
+    if (!same && !colSet(rec, cur)) {
+        derivedFail(&colIndex);
+        return;
+    }
+    derivedTouch(&colIndex, !same);
+}
+
+/* ---------- COLUMN KERNELS ---------- */
+
+/*
+ * Scans over the column store. Each kernel has a plain C version and an
+ * AVX2 version that handles eight students per step; colKernels() picks
+ * one once per process from what the CPU supports. Both versions return
+ * the same counts, and sums that differ only by rounding order.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define COL_HAVE_AVX2 1
+#endif
+
+#define COL_SIMD_GROUPS 16      /* AVX2 group-by keeps one accumulator per code */
+
+typedef struct {
+    long count;
+    double sum;
+    float min, max;
+} ColAgg;
+
+typedef struct {
+    const char *name;
+    void (*agg)(const float *v, const uint8_t *code, long n, ColAgg *out);
+    /* Live students with cgpa >= t (and the given code, unless it is 0);
+       their record numbers go to out unless it is NULL. */
+    long (*filter)(const float *v, const uint8_t *code, long n, float t, uint8_t only,
+                   int32_t *out);
+    /* Count and CGPA sum per code, for codes below nCodes. */
+    void (*group)(const float *v, const uint8_t *code, long n, uint32_t nCodes,
+                  int64_t *counts, double *sums);
+} ColKernels;
+
+void colAggScalar(const float *v, const uint8_t *code, long n, ColAgg *out) {
+    ColAgg a = { 0, 0.0, FLT_MAX, -FLT_MAX };
+    for (long i = 0; i < n; i++) {
+        if (code[i] == 0) continue;
+        a.count++;
+        a.sum += v[i];
+        if (v[i] < a.min) a.min = v[i];
+        if (v[i] > a.max) a.max = v[i];
+    }
+    *out = a;
+}
+
+long colFilterScalar(const float *v, const uint8_t *code, long n, float t, uint8_t only,
+                     int32_t *out) {
+    long hits = 0;
+    for (long i = 0; i < n; i++) {
+        if (code[i] == 0 || v[i] < t || (only && code[i] != only)) continue;
+        if (out) out[hits] = (int32_t)i;
+        hits++;
+    }
+    return hits;
+}
+
+void colGroupScalar(const float *v, const uint8_t *code, long n, uint32_t nCodes,
+                    int64_t *counts, double *sums) {
+    memset(counts, 0, sizeof(int64_t) * nCodes);
+    memset(sums, 0, sizeof(double) * nCodes);
+    for (long i = 0; i < n; i++) {
+        counts[code[i]]++;
+        sums[code[i]] += v[i];
+    }
+}
+
+#ifdef COL_HAVE_AVX2
+#include <immintrin.h>
+
+/* Eight codes widened to 32-bit lanes. */
+__attribute__((target("avx2")))
+static inline __m256i colLoadCodes(const uint8_t *code) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)code));
+}
+
+__attribute__((target("avx2")))
+static inline __m256d colSumPairs(__m256d acc, __m256 x) {
+    acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+    return _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+}
+
+__attribute__((target("avx2")))
+static inline double colHsum(__m256d v) {
+    double lane[4];
+    _mm256_storeu_pd(lane, v);
+    return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+
+__attribute__((target("avx2")))
+void colAggAvx2(const float *v, const uint8_t *code, long n, ColAgg *out) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256 lo = _mm256_set1_ps(FLT_MAX), hi = _mm256_set1_ps(-FLT_MAX);
+    __m256d sum = _mm256_setzero_pd();
+    __m256i dead = _mm256_setzero_si256();
+    long i = 0;
+
+    /* Deleted slots hold 0.0, so they can join the sum unmasked. */
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(v + i);
+        __m256i isDead = _mm256_cmpeq_epi32(colLoadCodes(code + i), zero);
+        __m256 deadMask = _mm256_castsi256_ps(isDead);
+        sum = colSumPairs(sum, x);
+        lo = _mm256_min_ps(lo, _mm256_blendv_ps(x, _mm256_set1_ps(FLT_MAX), deadMask));
+        hi = _mm256_max_ps(hi, _mm256_blendv_ps(x, _mm256_set1_ps(-FLT_MAX), deadMask));
+        dead = _mm256_sub_epi32(dead, isDead);
+    }
+
+    float l[8], h[8];
+    int32_t d[8];
+    _mm256_storeu_ps(l, lo);
+    _mm256_storeu_ps(h, hi);
+    _mm256_storeu_si256((__m256i *)d, dead);
+    ColAgg a;
+    colAggScalar(v + i, code + i, n - i, &a);
+    a.count += i;
+    a.sum += colHsum(sum);
+    for (int k = 0; k < 8; k++) {
+        a.count -= d[k];
+        if (l[k] < a.min) a.min = l[k];
+        if (h[k] > a.max) a.max = h[k];
+    }
+    *out = a;
+}
+
+__attribute__((target("avx2")))
+long colFilterAvx2(const float *v, const uint8_t *code, long n, float t, uint8_t only,
+                   int32_t *out) {
+    const __m256 tv = _mm256_set1_ps(t);
+    const __m256i zero = _mm256_setzero_si256(), want = _mm256_set1_epi32(only);
+    long hits = 0, i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i c = colLoadCodes(code + i);
+        __m256i keep = only ? _mm256_cmpeq_epi32(c, want)
+                            : _mm256_xor_si256(_mm256_cmpeq_epi32(c, zero), _mm256_set1_epi32(-1));
+        __m256 ge = _mm256_cmp_ps(_mm256_loadu_ps(v + i), tv, _CMP_GE_OQ);
+        unsigned bits = (unsigned)_mm256_movemask_ps(_mm256_and_ps(ge, _mm256_castsi256_ps(keep)));
+        if (!out) {
+            hits += __builtin_popcount(bits);
+            continue;
+        }
+        while (bits) {
+            out[hits++] = (int32_t)(i + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+    long tail = colFilterScalar(v + i, code + i, n - i, t, only, out ? out + hits : NULL);
+    if (out)
+        for (long k = hits; k < hits + tail; k++) out[k] += (int32_t)i;
+    return hits + tail;
+}
+
+__attribute__((target("avx2")))
+void colGroupAvx2(const float *v, const uint8_t *code, long n, uint32_t nCodes,
+                  int64_t *counts, double *sums) {
+    if (nCodes > COL_SIMD_GROUPS) {
+        colGroupScalar(v, code, n, nCodes, counts, sums);
+        return;
+    }
+    __m256d acc[COL_SIMD_GROUPS];
+    __m256i cnt[COL_SIMD_GROUPS];
+    for (uint32_t c = 0; c < nCodes; c++) {
+        acc[c] = _mm256_setzero_pd();
+        cnt[c] = _mm256_setzero_si256();
+    }
+
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(v + i);
+        __m256i cv = colLoadCodes(code + i);
+        for (uint32_t c = 0; c < nCodes; c++) {
+            __m256i m = _mm256_cmpeq_epi32(cv, _mm256_set1_epi32((int)c));
+            acc[c] = colSumPairs(acc[c], _mm256_and_ps(x, _mm256_castsi256_ps(m)));
+            cnt[c] = _mm256_sub_epi32(cnt[c], m);
+        }
+    }
+
+    colGroupScalar(v + i, code + i, n - i, nCodes, counts, sums);
+    for (uint32_t c = 0; c < nCodes; c++) {
+        int32_t lane[8];
+        _mm256_storeu_si256((__m256i *)lane, cnt[c]);
+        for (int k = 0; k < 8; k++) counts[c] += lane[k];
+        sums[c] += colHsum(acc[c]);
+    }
+}
+#endif
+
+static const ColKernels colScalarKernels = { "scalar", colAggScalar, colFilterScalar, colGroupScalar };
+#ifdef COL_HAVE_AVX2
+static const ColKernels colAvx2Kernels = { "AVX2", colAggAvx2, colFilterAvx2, colGroupAvx2 };
+#endif
+
+const ColKernels *colKernels() {
+#ifdef COL_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) return &colAvx2Kernels;
+#endif
+    return &colScalarKernels;
+}
+
+/* ---------- STUDENT SESSION ---------- */
+
+/*
+ * A logged-in student keeps a copy of their record and its record number,
+ * and reads are served from that copy while storeGeneration is unchanged.
+ * After any write to the store, the copy is checked against the record at
+ * its cached number. Only if that record now belongs to someone else
+ * (compaction renumbered it) is the ID looked up again. Writes go
+ * straight to the cached record number. Only one process has the
+ * database open (see LOCK_FILE), so the in-memory generation sees every
+ * change, including those made by other server sessions.
+ */
+
+typedef struct {
+    char sid[20];
+    Student s;
+    long rec;
+    uint64_t generation;
+} StudentSession;
+
+/* Start a session for id if pass is its password; returns 0 otherwise. */
+int sessionBegin(StudentSession *me, const char *id, const char *pass) {
+    long rec;
+    const Student *s = lookupStudent(id, &rec);
+    if (!s || strcmp(s->password, pass) != 0) return 0;
+    strcpy(me->sid, s->id);
+    me->s = *s;
+    me->rec = rec;
+    me->generation = storeGeneration;
+    return 1;
+}
+
+/* The session's student, revalidated if the store changed since it was
+   cached; NULL once the student has been deleted or renamed. */
+const Student *sessionStudent(StudentSession *me) {
+    if (!storeOpen(0)) return NULL;
+    if (me->generation != storeGeneration) {
+        const Student *cur = me->rec < storeCount() ? storeGet(me->rec) : NULL;
+        if (!cur || strcmp(cur->id, me->sid) != 0) {
+            long rec;
+            if (!(cur = lookupStudent(me->sid, &rec))) return NULL;
+            me->rec = rec;
+        }
+        me->s = *cur;
+        me->generation = storeGeneration;
+    }
+    return &me->s;
+}
+
+/* ---------- AUTH ---------- */
+
+int authAdmin(const char *user, const char *pass) {
+    return strcmp(user, "admin") == 0 && strcmp(pass, "admin123") == 0;
+}
+
+int authStudent(const char *id, const char *pass) {
+    const Student *s = lookupStudent(id, NULL);
+    return s && strcmp(s->password, pass) == 0;
+}
+
+int managementLogin() {
+    char u[32], p[32];
+
+    printf("----- MANAGEMENT LOGIN -----\n");
+    printf("Username: ");
+    readLine(u, sizeof(u));
+
+    printf("Password: ");
+    readLine(p, sizeof(p));
+
+    return authAdmin(u, p);
+}
+
+int studentLogin(StudentSession *me) {
+    char id[20];
+    char pass[20];
+    if (!storeOpen(0) || storeCount() == 0) {
+        printf("No student database found. Please add students first via Management Login.\n");
+        return 0;
+    }
+
+    printf("----- STUDENT LOGIN -----\n");
+    printf("Student ID: ");
+    readLine(id, sizeof(id));
+    
+    printf("Password: ");
+    readLine(pass, sizeof(pass));
+
+    if (sessionBegin(me, id, pass)) return 1;
+
+    printf("\nInvalid credentials or student not found.\n");
+    return 0;
+}
+
+/* ---------- PARALLEL EXPORT ---------- */
+
+/*
+ * Full exports split the store into chunks of EXPORT_CHUNK records.
+ * Worker threads claim chunks in order and format each one into a
+ * per-chunk buffer for every requested format, while the calling thread
+ * writes finished chunks out strictly in chunk order. Only a few chunks
+ * per worker are in flight at a time, so memory stays bounded however
+ * large the roster is. One pass can feed several sinks, e.g. a CSV and a
+ * JSON file, or the TXT listing to both stdout and students.txt.
+ */
+
+#define EXPORT_CHUNK       8192
+#define EXPORT_MAX_THREADS 32
+#define EXPORT_SLOTS       2      /* chunk buffers per worker */
+#define EXPORT_ROW_MAX     1024   /* longest formatted row, JSON escapes included */
+#define CSV_HEADER "ID,Name,Branch,Section,CGPA,Phone\n"
+
+enum { EXPORT_CSV, EXPORT_TXT, EXPORT_JSON, EXPORT_FORMAT_COUNT };
+
+typedef struct {
+    const char *header;
+    const char *separator;        /* between rows */
+    const char *footer;
+    size_t (*format)(char *dst, const Student *s);
+} ExportFormat;
+
+typedef struct {
+    int format;
+    FILE *fp;
+} ExportSink;
+
+typedef struct {
+    char *buf[EXPORT_FORMAT_COUNT];
+    size_t len[EXPORT_FORMAT_COUNT];
+    size_t cap[EXPORT_FORMAT_COUNT];
+    long rows;
+    long ready;                   /* chunk the buffers hold; -1 while empty */
+} ExportSlot;
+
+typedef struct {
+    unsigned formats;             /* bit per EXPORT_* format */
+    long chunks;
+    long next;                    /* next chunk to claim */
+    long written;                 /* chunks already written out */
+    int failed;
+    int nSlots;
+    ExportSlot *slots;
+    pthread_mutex_t mu;
+    pthread_cond_t ready;
+    pthread_cond_t freed;
+} ExportJob;
+
+size_t appendField(char *dst, const char *src, size_t max) {
+    size_t n = strnlen(src, max);
+    memcpy(dst, src, n);
+    return n;
+}
+
+/* Format a CGPA with a %.2f pattern into at most max - 1 bytes. */
+size_t appendCgpa(char *dst, size_t max, const char *fmt, float cgpa) {
+    int n = snprintf(dst, max, fmt, cgpaClamp(cgpa));
+    if (n < 0) return 0;
+    return (size_t)n < max ? (size_t)n : max - 1;
+}
+
+/* Format one CSV row into dst (at least 160 bytes); returns its length. */
+size_t csvFormatRow(char *dst, const Student *s) {
+    size_t n = 0;
+    n += appendField(dst + n, s->id, sizeof(s->id));
+    dst[n++] = ',';
+    n += appendField(dst + n, s->name, sizeof(s->name));
+    dst[n++] = ',';
+    n += appendField(dst + n, s->branch, sizeof(s->branch));
+    dst[n++] = ',';
+    n += appendField(dst + n, s->section, sizeof(s->section));
+    n += appendCgpa(dst + n, 24, ",%.2f,", s->cgpa);
+    n += appendField(dst + n, s->phone, sizeof(s->phone));
+    dst[n++] = '\n';
+    return n;
+}
+
+/* The listing format of "View All Students". */
+size_t txtFormatRow(char *dst, const Student *s) {
+    return (size_t)snprintf(dst, EXPORT_ROW_MAX,
+                            "\nID: %.20s\nName: %.50s\nBranch: %.20s\nSection: %.10s\nCGPA: %.2f\nPhone: %.15s\n",
+                            s->id, s->name, s->branch, s->section, cgpaClamp(s->cgpa), s->phone);
+}
+
+size_t jsonString(char *dst, const char *src, size_t max) {
+    size_t n = 0;
+    dst[n++] = '"';
+    for (size_t i = 0; i < max && src[i]; i++) {
+        unsigned char c = (unsigned char)src[i];
+        if (c == '"' || c == '\\') {
+            dst[n++] = '\\';
+            dst[n++] = (char)c;
+        } else if (c < 0x20) {
+            n += (size_t)sprintf(dst + n, "\\u%04x", c);
+        } else {
+            dst[n++] = (char)c;
+        }
+    }
+    dst[n++] = '"';
+    return n;
+}
+
+size_t jsonFormatRow(char *dst, const Student *s) {
+    size_t n = 0;
+    n += appendField(dst + n, "\n  {\"id\": ", 16);
+    n += jsonString(dst + n, s->id, sizeof(s->id));
+    n += appendField(dst + n, ", \"name\": ", 16);
+    n += jsonString(dst + n, s->name, sizeof(s->name));
+    n += appendField(dst + n, ", \"branch\": ", 16);
+    n += jsonString(dst + n, s->branch, sizeof(s->branch));
+    n += appendField(dst + n, ", \"section\": ", 16);
+    n += jsonString(dst + n, s->section, sizeof(s->section));
+    n += appendCgpa(dst + n, 32, ", \"cgpa\": %.2f", s->cgpa);
+    n += appendField(dst + n, ", \"phone\": ", 16);
+    n += jsonString(dst + n, s->phone, sizeof(s->phone));
+    dst[n++] = '}';
+    return n;
+}
+
+static const ExportFormat exportFormats[EXPORT_FORMAT_COUNT] = {
+    { CSV_HEADER, "", "", csvFormatRow },
+    { "----- ALL STUDENTS -----\n", "", "", txtFormatRow },
+    { "[", ",", "\n]\n", jsonFormatRow },
+};
+
+int exportReserve(ExportSlot *slot, int f, size_t need) {
+    if (slot->len[f] + need <= slot->cap[f]) return 1;
+    size_t cap = slot->cap[f] ? slot->cap[f] : (size_t)EXPORT_CHUNK * 64;
+    while (cap < slot->len[f] + need) cap *= 2;
+    char *buf = (char *)realloc(slot->buf[f], cap);
+    if (!buf) return 0;
+    slot->buf[f] = buf;
+    slot->cap[f] = cap;
+    return 1;
+}
+
+/* Format the live records of one chunk into the slot's buffers. */
+int exportFill(const ExportJob *job, ExportSlot *slot, long chunk) {
+    long from = chunk * EXPORT_CHUNK;
+    long to = from + EXPORT_CHUNK < storeCount() ? from + EXPORT_CHUNK : storeCount();
+
+    slot->rows = 0;
+    for (int f = 0; f < EXPORT_FORMAT_COUNT; f++) slot->len[f] = 0;
+
+    for (long i = from; i < to; i++) {
+        const Student *s = storeGet(i);
+        if (!isLive(s)) continue;
+        for (int f = 0; f < EXPORT_FORMAT_COUNT; f++) {
+            if (!(job->formats & (1u << f))) continue;
+            const ExportFormat *fmt = &exportFormats[f];
+            size_t sep = slot->rows ? strlen(fmt->separator) : 0;
+            if (!exportReserve(slot, f, sep + EXPORT_ROW_MAX)) return 0;
+            memcpy(slot->buf[f] + slot->len[f], fmt->separator, sep);
+            slot->len[f] += sep;
+            slot->len[f] += fmt->format(slot->buf[f] + slot->len[f], s);
+        }
+        slot->rows++;
+    }
+    return 1;
+}
+
+void *exportWorker(void *arg) {
+    ExportJob *job = (ExportJob *)arg;
+
+    pthread_mutex_lock(&job->mu);
+    while (!job->failed && job->next < job->chunks) {
+        long chunk = job->next++;
+        ExportSlot *slot = &job->slots[chunk % job->nSlots];
+        while (!job->failed && chunk - job->written >= job->nSlots)
+            pthread_cond_wait(&job->freed, &job->mu);
+        if (job->failed) break;
+        pthread_mutex_unlock(&job->mu);
+
+        int ok = exportFill(job, slot, chunk);
+
+        pthread_mutex_lock(&job->mu);
+        if (ok) slot->ready = chunk;
+        else job->failed = 1;
+        pthread_cond_broadcast(&job->ready);
+        if (!ok) pthread_cond_broadcast(&job->freed);
+    }
+    pthread_mutex_unlock(&job->mu);
+    return NULL;
+}
+
+int exportThreads(long chunks) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > EXPORT_MAX_THREADS) n = EXPORT_MAX_THREADS;
+    if (n > chunks) n = chunks;
+    return n < 1 ? 1 : (int)n;
+}
+
+/*
+ * Write every live student to each sink, in record order, using all
+ * cores for the formatting. The caller owns the sinks' files. Returns
+ * the number of rows, or -1 if a buffer or write failed.
+ */
+long exportRun(const ExportSink *sinks, int nSinks) {
+    ExportJob job;
+    pthread_t tids[EXPORT_MAX_THREADS];
+    int started = 0;
+    long rows = 0;
+
+    memset(&job, 0, sizeof(job));
+    for (int k = 0; k < nSinks; k++) job.formats |= 1u << sinks[k].format;
+    job.chunks = (storeCount() + EXPORT_CHUNK - 1) / EXPORT_CHUNK;
+
+    int threads = exportThreads(job.chunks);
+    job.nSlots = threads * EXPORT_SLOTS;
+    job.slots = (ExportSlot *)calloc((size_t)job.nSlots, sizeof(ExportSlot));
+    if (!job.slots) return -1;
+    for (int i = 0; i < job.nSlots; i++) job.slots[i].ready = -1;
+    pthread_mutex_init(&job.mu, NULL);
+    pthread_cond_init(&job.ready, NULL);
+    pthread_cond_init(&job.freed, NULL);
+
+    for (int k = 0; k < nSinks; k++) fputs(exportFormats[sinks[k].format].header, sinks[k].fp);
+
+    for (int i = 0; i < threads && job.chunks > 0; i++)
+        if (pthread_create(&tids[i], NULL, exportWorker, &job) == 0) started++;
+    if (started == 0 && job.chunks > 0) job.failed = 1;
+
+    for (long chunk = 0; chunk < job.chunks; chunk++) {
+        ExportSlot *slot = &job.slots[chunk % job.nSlots];
+        pthread_mutex_lock(&job.mu);
+        while (!job.failed && slot->ready != chunk) pthread_cond_wait(&job.ready, &job.mu);
+        int failed = job.failed;
+        pthread_mutex_unlock(&job.mu);
+        if (failed) break;
+
+        for (int k = 0; k < nSinks; k++) {
+            int f = sinks[k].format;
+            if (rows && slot->rows) fputs(exportFormats[f].separator, sinks[k].fp);
+            fwrite(slot->buf[f], 1, slot->len[f], sinks[k].fp);
+            if (ferror(sinks[k].fp)) failed = 1;
+        }
+        rows += slot->rows;
+
+        pthread_mutex_lock(&job.mu);
+        job.written++;
+        if (failed) job.failed = 1;
+        pthread_cond_broadcast(&job.freed);
+        pthread_mutex_unlock(&job.mu);
+    }
+
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    for (int k = 0; k < nSinks; k++) {
+        fputs(exportFormats[sinks[k].format].footer, sinks[k].fp);
+        if (ferror(sinks[k].fp)) job.failed = 1;
+    }
+
+    for (int i = 0; i < job.nSlots; i++)
+        for (int f = 0; f < EXPORT_FORMAT_COUNT; f++) free(job.slots[i].buf[f]);
+    free(job.slots);
+    pthread_mutex_destroy(&job.mu);
+    pthread_cond_destroy(&job.ready);
+    pthread_cond_destroy(&job.freed);
+    return job.failed ? -1 : rows;
+}
+
+/* ---------- CSV EXPORT ---------- */
+
+/*
+ * students.csv is kept up to date lazily. An added student is appended as
+ * one row. Any other change only marks the export stale, and the file is
+ * regenerated once: when the management session ends, when the program
+ * exits, or on an explicit export. The stale mark is also a marker file,
+ * so a session that never reached logout still refreshes the CSV next
+ * time.
+ */
+
+#define CSV_BUF_SIZE (1 << 20)
+
+static int csvStale = -1;     /* -1: not checked yet */
+static const char *const exportPaths[EXPORT_FORMAT_COUNT] = { CSV_FILE, TXT_FILE, JSON_FILE };
+
+int fileExists(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+int csvIsStale() {
+    if (csvStale < 0)
+        csvStale = fileExists(CSV_STALE_FILE) || !fileExists(CSV_FILE);
+    return csvStale;
+}
+
+void csvMarkStale() {
+    if (csvIsStale()) return;
+    FILE *fp = fopen(CSV_STALE_FILE, "w");
+    if (fp) fclose(fp);
+    csvStale = 1;
+}
+
+/* Append a newly added student, unless a full refresh is pending anyway. */
+void csvAppendStudent(const Student *s) {
+    char row[192];
+    if (csvIsStale()) return;
+    FILE *fp = fopen(CSV_FILE, "a");
+    if (!fp) {
+        csvMarkStale();
+        return;
+    }
+    fwrite(row, 1, csvFormatRow(row, s), fp);
+    fclose(fp);
+}
+
+/* Write the formats in the mask (a bit per EXPORT_*) to their files in
+   one parallel pass; returns the number of rows, or -1 if there is no
+   store or a file can't be written. Writing the CSV clears its stale mark. */
+long exportFiles(unsigned formats) {
+    ExportSink sinks[EXPORT_FORMAT_COUNT];
+    int n = 0;
+    long rows = -1;
+
+    if (!storeOpen(0)) return -1;
+    for (int f = 0; f < EXPORT_FORMAT_COUNT; f++) {
+        if (!(formats & (1u << f))) continue;
+        sinks[n].format = f;
+        sinks[n].fp = fopen(exportPaths[f], "w");
+        if (!sinks[n].fp) break;
+        n++;
+    }
+    if (n == __builtin_popcount(formats)) rows = exportRun(sinks, n);
+    for (int k = 0; k < n; k++)
+        if (fclose(sinks[k].fp) != 0) rows = -1;
+
+    if (rows >= 0 && (formats & (1u << EXPORT_CSV))) {
+        remove(CSV_STALE_FILE);
+        csvStale = 0;
+    }
+    return rows;
+}
+
+long autoExportCSV() {
+    return exportFiles(1u << EXPORT_CSV);
+}
+
+/* Regenerate the CSV if it is stale (or always, if force is set). */
+long csvFlush(int force) {
+    if (!force && !csvIsStale()) return 0;
+    return autoExportCSV();
+}
+
+/* ---------- STUDENT WRITES ---------- */
+
+/*
+ * Every change to students.dat goes through studentInsert, studentUpdate
+ * or studentDelete. Each one brings the indexes up to date before writing
+ * and then applies the change to them, so no index needs a rescan.
+ */
+
+static DerivedIndex *const derivedIndexes[] = { &idIndex, &cgpaIndex.di, &nameIndex.di,
+                                                 &statsIndex, &colIndex, &triIndex };
+#define DERIVED_INDEX_COUNT (sizeof(derivedIndexes) / sizeof(derivedIndexes[0]))
+
+/* Writes need the ID index; the others fall back to scans without it. */
+int indexesPrepare() {
+    for (size_t i = 0; i < DERIVED_INDEX_COUNT; i++)
+        derivedEnsure(derivedIndexes[i]);
+    return idIndex.loaded;
+}
+
+void indexesApply(long rec, const Student *old, const Student *cur) {
+    idxApply(rec, old, cur);
+    for (size_t i = 0; i < SORT_INDEX_COUNT; i++)
+        sortIdxApply(sortIndexes[i], rec, old, cur);
+    statsApply(old, cur);
+    colApply(rec, old, cur);
+    triApply(rec, old, cur);
+}
+
+/* Restamp every loaded index after deferred log writes reached the store
+   files; the writes themselves were already applied to the indexes. */
+void indexesRestamp() {
+    for (size_t i = 0; i < DERIVED_INDEX_COUNT; i++)
+        if (derivedIndexes[i]->loaded) derivedTouch(derivedIndexes[i], 0);
+}
+
+/* Drop every index keyed by record number after students.dat was
+   rewritten wholesale. The stats block only depends on the live records,
+   so it just takes the new stamp. */
+void indexesInvalidate() {
+    for (size_t i = 0; i < DERIVED_INDEX_COUNT; i++) {
+        DerivedIndex *d = derivedIndexes[i];
+        if (d != &statsIndex) derivedInvalidate(d);
+        else if (d->loaded) derivedTouch(d, 0);
+    }
+}
+
+int csvFieldsDiffer(const Student *a, const Student *b) {
+    return strcmp(a->id, b->id) != 0 || strcmp(a->name, b->name) != 0 ||
+           strcmp(a->branch, b->branch) != 0 || strcmp(a->section, b->section) != 0 ||
+           a->cgpa != b->cgpa || strcmp(a->phone, b->phone) != 0;
+}
+
+/* Append a new student; returns its record number or -1. */
+long studentInsert(const Student *s) {
+    if (!storeOpen(1) || !indexesPrepare()) return -1;
+    long rec = storeAppend(s);
+    if (rec < 0) return -1;
+    indexesApply(rec, NULL, s);
+    csvAppendStudent(s);
+    return rec;
+}
+
+int studentUpdate(long rec, const Student *s) {
+    if (!indexesPrepare()) return 0;
+    Student old = *storeGet(rec);
+    if (!storeWrite(rec, s)) return 0;
+    indexesApply(rec, &old, s);
+    if (csvFieldsDiffer(&old, s)) csvMarkStale();
+    return 1;
+}
+
+/* Returns records reclaimed by compaction, or -1 on error. */
+long studentsCompact() {
+    int rewritten;
+    derivedEnsure(&statsIndex);
+    long reclaimed = storeCompact(&rewritten);
+    if (rewritten) {
+        indexesInvalidate();
+        indexesPrepare();           /* rebuild now, while we hold the store */
+    }
+    return reclaimed;
+}
+
+int studentDelete(long rec) {
+    if (!indexesPrepare()) return 0;
+    Student old = *storeGet(rec);
+    if (!storeKill(rec)) return 0;
+    indexesApply(rec, &old, NULL);
+    csvMarkStale();
+    if (storeNeedsCompaction()) studentsCompact();
+    return 1;
+}
+
+/*
+ * ID-level operations shared by the menus and the server. Each returns
+ * NULL on success, or a short reason why nothing was changed.
+ */
+
+static const char ERR_EXISTS[]   = "ID already exists";
+static const char ERR_NOTFOUND[] = "ID not found";
+static const char ERR_WRITE[]    = "cannot write student file";
+static const char ERR_CGPA[]     = "CGPA out of range";
+
+/* Reset s to the default password for its ID. */
+void setDefaultPassword(Student *s) {
+    defaultPasswordOf(s->id, s->password, sizeof(s->password));
+}
+
+/* Add s with the default password, which is stored back into s. */
+const char *opAddStudent(Student *s) {
+    if (s->id[0] == '\0') return "empty ID";
+    if (!cgpaValid(s->cgpa)) return ERR_CGPA;
+    if (lookupStudent(s->id, NULL)) return ERR_EXISTS;
+    setDefaultPassword(s);
+    return studentInsert(s) < 0 ? ERR_WRITE : NULL;
+}
+
+/* Replace the profile fields of student s->id, keeping the password. */
+const char *opUpdateStudent(const Student *s) {
+    long rec;
+    Student cur;
+    if (!cgpaValid(s->cgpa)) return ERR_CGPA;
+    if (!findStudent(s->id, &cur, &rec)) return ERR_NOTFOUND;
+    strcpy(cur.name, s->name);
+    strcpy(cur.branch, s->branch);
+    strcpy(cur.section, s->section);
+    cur.cgpa = s->cgpa;
+    strcpy(cur.phone, s->phone);
+    return studentUpdate(rec, &cur) ? NULL : ERR_WRITE;
+}
+
+const char *opDeleteStudent(const char *id) {
+    long rec;
+    if (id[0] == '\0' || !lookupStudent(id, &rec)) return ERR_NOTFOUND;
+    return studentDelete(rec) ? NULL : ERR_WRITE;
+}
+
+/* Rename a student; the password is reset to the default for the new ID. */
+const char *opChangeStudentId(const char *oldId, const char *newId) {
+    long rec;
+    Student s;
+    if (newId[0] == '\0') return "empty ID";
+    if (strcmp(oldId, newId) != 0 && lookupStudent(newId, NULL)) return ERR_EXISTS;
+    if (!findStudent(oldId, &s, &rec)) return ERR_NOTFOUND;
+    strcpy(s.id, newId);
+    setDefaultPassword(&s);
+    return studentUpdate(rec, &s) ? NULL : ERR_WRITE;
+}
+
+/* Change the logged-in student's password through the cached record. */
+const char *opSetSessionPassword(StudentSession *me, const char *pass) {
+    const Student *cur = sessionStudent(me);
+    if (!cur) return ERR_NOTFOUND;
+    Student s = *cur;
+    memset(s.password, 0, sizeof(s.password));
+    strncpy(s.password, pass, sizeof(s.password) - 1);
+    if (!studentUpdate(me->rec, &s)) return ERR_WRITE;
+    me->s = s;
+    me->generation = storeGeneration;
+    return NULL;
+}
+
+/* Write back everything that is deferred to the end of a session. */
+void sessionFlush() {
+    csvFlush(0);
+    for (size_t i = 0; i < DERIVED_INDEX_COUNT; i++)
+        derivedFlush(derivedIndexes[i]);
+    walCheckpoint();
+}
+
+/* ---------- MANAGEMENT: CRUD ---------- */
+
+void addStudent() {
+    Student s;
+    memset(&s, 0, sizeof(Student));
+    if (!storeOpen(1)) {
+        perror("Cannot open student file");
+        pauseScreen();
+        return;
+    }
+
+    printf("----- ADD STUDENT -----\n");
+
+    printf("ID: ");
+    readLine(s.id, sizeof(s.id));
+
+    if (lookupStudent(s.id, NULL)) {
+        printf("\nA student with ID %s already exists.\n", s.id);
+        pauseScreen();
+        return;
+    }
+
+    printf("Name: ");
+    readLine(s.name, sizeof(s.name));
+
+    printf("Branch: ");
+    readLine(s.branch, sizeof(s.branch));
+
+    printf("Section: ");
+    readLine(s.section, sizeof(s.section));
+
+    printf("CGPA: ");
+    s.cgpa = readCgpa();
+
+    printf("Phone: ");
+    readLine(s.phone, sizeof(s.phone));
+
+    const char *err = opAddStudent(&s);
+    if (err) {
+        printf("\nStudent not added: %s.\n", err);
+        pauseScreen();
+        return;
+    }
+
+    printf("\nStudent added.\n");
+    printf("Default password: %s\n", s.password);
+    
+    pauseScreen();
+}
+
+void displayAll() {
+    if (!storeOpen(0)) {
+        printf("No data.\n");
+        pauseScreen();
+        return;
+    }
+
+    ExportSink sinks[2] = { { EXPORT_TXT, stdout }, { EXPORT_TXT, fopen(TXT_FILE, "w") } };
+    if (!sinks[1].fp) {
+        printf("Warning: Could not create %s (txt export will be skipped).\n", TXT_FILE);
+    }
+
+    printf("\n");
+    exportRun(sinks, sinks[1].fp ? 2 : 1);
+    fflush(stdout);
+
+    if (sinks[1].fp) {
+        fclose(sinks[1].fp);
+        printf("\nData also written to %s\n", TXT_FILE);
+    }
+
+    pauseScreen();
+}
+
+void updateStudent() {
+    char id[20];
+    int found = 0;
+    long rec;
+    Student s;
+    if (!storeOpen(0)) {
+        printf("No student file.\n");
+        pauseScreen();
+        return;
+    }
+
+    printf("\nEnter ID to update: ");
+    readLine(id, sizeof(id));
+
+    if (findStudent(id, &s, &rec)) {
+        found = 1;
+
+        printf("New Name: ");
+        readLine(s.name, sizeof(s.name));
+
+        printf("New Branch: ");
+        readLine(s.branch, sizeof(s.branch));
+
+        printf("New Section: ");
+        readLine(s.section, sizeof(s.section));
+
+        printf("New CGPA: ");
+        s.cgpa = readCgpa();
+
+        printf("New Phone: ");
+        readLine(s.phone, sizeof(s.phone));
+
+        found = opUpdateStudent(&s) == NULL;
+    }
+
+    if (found) {
+        printf("\nUpdated.\n");
+    } else {
+        printf("\nID not found.\n");
+    }
+
+    pauseScreen();
+}
+
+void deleteStudent() {
+    char id[20];
+
+    if (!storeOpen(0)) {
+        printf("Error opening files.\n");
+        pauseScreen();
+        return;
+    }
+
+    printf("\nEnter ID to delete: ");
+    readLine(id, sizeof(id));
+
+    if (opDeleteStudent(id) == NULL) {
+        printf("Deleted.\n");
+    } else {
+        printf("ID not found.\n");
+    }
+
+    pauseScreen();
+}
+
+void changeStudentId() {
+    char oldId[20], newId[20];
+    if (!storeOpen(0)) {
+        printf("No student file.\n");
+        pauseScreen();
+        return;
+    }
+
+    printf("\nEnter old ID: ");
+    readLine(oldId, sizeof(oldId));
+
+    printf("Enter new ID: ");
+    readLine(newId, sizeof(newId));
+
+    const char *err = opChangeStudentId(oldId, newId);
+    if (!err) {
+        printf("\nID changed.\n");
+    } else if (err == ERR_EXISTS) {
+        printf("\nA student with ID %s already exists.\n", newId);
+    } else if (err == ERR_NOTFOUND) {
+        printf("\nOld ID not found.\n");
+    } else {
+        printf("\nID not changed: %s.\n", err);
+    }
+
+    pauseScreen();
+}
+
+/* ---------- ANALYTICS & SORTING ---------- */
+
+void printStudent(const Student *s) {
+    printf("\nID: %s\nName: %s\nBranch: %s\nSection: %s\nCGPA: %.2f\nPhone: %s\n",
+           s->id, s->name, s->branch, s->section, s->cgpa, s->phone);
+}
+
+void printGroups(const char *title, const StatsGroups *g) {
+    printf("\n----- %s -----\n", title);
+    printf("%-20s %10s %10s\n", "Group", "Students", "Avg CGPA");
+    for (uint32_t i = 0; i < g->n; i++) {
+        const StatsGroup *grp = &g->items[i];
+        if (grp->count <= 0) continue;
+        printf("%-20s %10lld %10.2f\n", grp->key[0] ? grp->key : "(blank)",
+               (long long)grp->count, (double)grp->sum / CGPA_FIXED / (double)grp->count);
+    }
+}
+
+void printHistogram() {
+    int64_t bins[10] = { 0 }, widest = 1;
+    for (int b = 0; b < STATS_BUCKETS; b++)
+        bins[b / 100 < 10 ? b / 100 : 9] += statsHist[b];
+    for (int i = 0; i < 10; i++)
+        if (bins[i] > widest) widest = bins[i];
+
+    printf("\n----- CGPA HISTOGRAM -----\n");
+    for (int i = 0; i < 10; i++) {
+        int bar = (int)(bins[i] * 40 / widest);
+        printf("[%2d,%2d%c %8lld | ", i, i + 1, i == 9 ? ']' : ')', (long long)bins[i]);
+        for (int j = 0; j < bar; j++) putchar('#');
+        putchar('\n');
+    }
+}
+
+/* Live students with CGPA >= t, optionally only in one branch. Served by
+   the column kernels; falls back to a row scan without a column store. */
+void filterByCgpa() {
+    char branch[20];
+    printf("Minimum CGPA: ");
+    float t = readFloat();
+    printf("Branch (blank for all): ");
+    readLine(branch, sizeof(branch));
+
+    int32_t *hits = (int32_t *)malloc(sizeof(int32_t) * (storeCount() + 1));
+    if (!hits) {
+        printf("Out of memory.\n");
+        return;
+    }
+    long n = 0;
+    if (derivedEnsure(&colIndex)) {
+        uint8_t code = 0;
+        if (!branch[0] ||
+            (code = dictFind(&cols.branchKeys[0][0], sizeof(cols.branchKeys[0]),
+                                cols.nBranch, branch)) != 0)
+            n = colKernels()->filter(cols.cgpa, cols.branch, cols.count, t, code, hits);
+    } else {
+        for (long i = 0; i < storeCount(); i++) {
+            const Student *s = storeGet(i);
+            if (isLive(s) && cgpaClamp(s->cgpa) >= t && (!branch[0] || strcmp(s->branch, branch) == 0))
+                hits[n++] = (int32_t)i;
+        }
+    }
+
+    printf("\n----- CGPA >= %.2f%s%s (%ld students) -----\n", t,
+           branch[0] ? " IN " : "", branch, n);
+    for (long i = 0; i < n; i++) printStudent(storeGet(hits[i]));
+    free(hits);
+}
+
+double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/*
+ * Column scan benchmark: the same three scans (sum/min/max, group by
+ * branch, CGPA threshold) as a row scan over students.dat, with the
+ * scalar column kernels and with the kernels picked for this CPU.
+ */
+
+#define BENCH_RUNS 5
+
+enum { SCAN_AGG, SCAN_GROUP, SCAN_FILTER, SCAN_KINDS };
+static const char *const scanNames[SCAN_KINDS] = { "Sum/min/max", "Group by branch", "CGPA filter" };
+
+typedef struct {
+    ColAgg agg;
+    long hits;
+    long groups;            /* non-empty branches */
+} ScanResult;
+
+void rowScan(int kind, float t, ScanResult *r) {
+    memset(r, 0, sizeof(*r));
+    if (kind == SCAN_AGG) {
+        ColAgg a = { 0, 0.0, FLT_MAX, -FLT_MAX };
+        for (long i = 0; i < storeCount(); i++) {
+            const Student *s = storeGet(i);
+            if (!isLive(s)) continue;
+            float v = cgpaClamp(s->cgpa);
+            a.count++;
+            a.sum += v;
+            if (v < a.min) a.min = v;
+            if (v > a.max) a.max = v;
+        }
+        r->agg = a;
+    } else if (kind == SCAN_GROUP) {
+        StatsGroups g = { NULL, 0, 0 };
+        StatsGroup *grp;
+        for (long i = 0; i < storeCount(); i++) {
+            const Student *s = storeGet(i);
+            if (isLive(s) && (grp = statsGroup(&g, s->branch))) {
+                grp->count++;
+                grp->sum += cgpaFixed(s->cgpa);
+            }
+        }
+        r->groups = (long)g.n;
+        free(g.items);
+    } else {
+        for (long i = 0; i < storeCount(); i++) {
+            const Student *s = storeGet(i);
+            if (isLive(s) && cgpaClamp(s->cgpa) >= t) r->hits++;
+        }
+    }
+}
+
+void colScan(const ColKernels *k, int kind, float t, ScanResult *r) {
+    int64_t counts[COL_MAX_CODES + 1];
+    double sums[COL_MAX_CODES + 1];
+    memset(r, 0, sizeof(*r));
+    if (kind == SCAN_AGG) {
+        k->agg(cols.cgpa, cols.branch, cols.count, &r->agg);
+    } else if (kind == SCAN_GROUP) {
+        k->group(cols.cgpa, cols.branch, cols.count, cols.nBranch, counts, sums);
+        for (uint32_t c = 1; c < cols.nBranch; c++)
+            if (counts[c] > 0) r->groups++;
+    } else {
+        r->hits = k->filter(cols.cgpa, cols.branch, cols.count, t, 0, NULL);
+    }
+}
+
+int scanResultsAgree(int kind, const ScanResult *a, const ScanResult *b) {
+    if (kind == SCAN_AGG) {
+        double drift = a->agg.sum - b->agg.sum;
+        if (drift < 0) drift = -drift;
+        return a->agg.count == b->agg.count && a->agg.min == b->agg.min &&
+               a->agg.max == b->agg.max && drift <= 1e-6 * (double)(a->agg.count + 1);
+    }
+    return a->hits == b->hits && a->groups == b->groups;
+}
+
+void columnBenchmark() {
+    if (!derivedEnsure(&colIndex) || cols.count == 0) {
+        printf("\nNo column store to benchmark.\n");
+        return;
+    }
+    const ColKernels *best = colKernels();
+    const ColKernels *variants[2] = { &colScalarKernels, best };
+    float t = derivedEnsure(&statsIndex) ? statsPercentile(0.90) : 9.0f;
+    int agree = 1;
+
+    printf("\n----- COLUMN SCAN BENCHMARK (%ld records, best of %d) -----\n",
+           cols.count, BENCH_RUNS);
+    printf("%-16s %12s %12s %12s %9s\n", "Scan", "Row scan", "Cols scalar", "Cols SIMD", "Speedup");
+    for (int kind = 0; kind < SCAN_KINDS; kind++) {
+        double ms[3];
+        ScanResult ref, got;
+        for (int v = 0; v < 3; v++) {
+            ms[v] = 1e30;
+            for (int run = 0; run < BENCH_RUNS; run++) {
+                double t0 = nowSeconds();
+                if (v == 0) rowScan(kind, t, &ref);
+                else colScan(variants[v - 1], kind, t, &got);
+                double el = (nowSeconds() - t0) * 1e3;
+                if (el < ms[v]) ms[v] = el;
+            }
+            if (v > 0 && !scanResultsAgree(kind, &ref, &got)) agree = 0;
+        }
+        printf("%-16s %9.2f ms %9.2f ms %9.2f ms %8.1fx\n", scanNames[kind],
+               ms[0], ms[1], ms[2], ms[2] > 0 ? ms[0] / ms[2] : 0.0);
+    }
+    printf("SIMD kernels: %s. Filter threshold: CGPA >= %.2f. Results %s.\n",
+           best->name, t, agree ? "agree" : "DIFFER");
+}
+
+/* Served from the stats block and the ends of the CGPA index, so the cost
+   does not depend on the number of students. */
+void showAnalytics() {
+    if (!derivedEnsure(&statsIndex) || stats.count <= 0 || !derivedEnsure(&cgpaIndex.di) ||
+        cgpaIndex.count == 0) {
+        printf("\nNo students found.\n");
+        pauseScreen();
+        return;
+    }
+
+    const Student *lo = storeGet(cgpaIndex.recs[0]);
+    const Student *hi = storeGet(cgpaIndex.recs[cgpaIndex.count - 1]);
+    double avg = (double)stats.sum / CGPA_FIXED / (double)stats.count;
+
+    printf("\n----- ANALYTICS -----\n");
+    printf("Total Students : %lld\n", (long long)stats.count);
+    printf("Average CGPA   : %.2f\n", avg);
+
+    printf("\nHighest CGPA:\n");
+    printf("ID: %s | Name: %s | CGPA: %.2f\n", hi->id, hi->name, cgpaClamp(hi->cgpa));
+
+    printf("\nLowest CGPA:\n");
+    printf("ID: %s | Name: %s | CGPA: %.2f\n", lo->id, lo->name, cgpaClamp(lo->cgpa));
+
+    printf("\nPercentiles:\n");
+    printf("P10: %.2f | P25: %.2f | P50: %.2f | P75: %.2f | P90: %.2f | P99: %.2f\n",
+           statsPercentile(0.10), statsPercentile(0.25), statsPercentile(0.50),
+           statsPercentile(0.75), statsPercentile(0.90), statsPercentile(0.99));
+
+    while (1) {
+        printf("\n1. CGPA Histogram\n");
+        printf("2. Group by Branch\n");
+        printf("3. Group by Section\n");
+        printf("4. Filter by CGPA and Branch\n");
+        printf("5. Column Scan Benchmark\n");
+        printf("0. Back\n");
+        printf("Choose: ");
+
+        switch (readInt()) {
+            case 1: printHistogram(); break;
+            case 2: printGroups("BY BRANCH", &statsBranch); break;
+            case 3: printGroups("BY SECTION", &statsSection); break;
+            case 4: filterByCgpa(); break;
+            case 5: columnBenchmark(); break;
+            case 0: return;
+            default: printf("Invalid.\n");
+        }
+    }
+}
+
+/* Print entries [from, to) of a sorted index, backwards if reverse is set. */
+void printSortedRange(const SortIndex *ix, long from, long to, int reverse) {
+    for (long i = 0; i < to - from; i++) {
+        long pos = reverse ? to - 1 - i : from + i;
+        printStudent(storeGet(ix->recs[pos]));
+    }
+}
+
+/* Sorted views are served from the CGPA and name indexes; the order of
+   students.dat is left alone. */
 void sortStudentsMenu() {
-    Student arr[MAX_STUDENTS];
-    int n = loadAllStudents(arr, MAX_STUDENTS);
-    if (n == 0) {
+    if (!derivedEnsure(&cgpaIndex.di) || !derivedEnsure(&nameIndex.di) ||
+        cgpaIndex.count == 0) {
         printf("\nNo students to sort.\n");
         pauseScreen();
         return;
     }
 
-    int choice;
-    printf("\n----- SORTING OPTIONS -----\n");
-    printf("1. By CGPA (Ascending)\n");
-    printf("2. By CGPA (Descending)\n");
-    printf("3. By Name (A-Z)\n");
+    int choice;
+    printf("\n----- SORTING OPTIONS -----\n");
+    printf("1. By CGPA (Ascending)\n");
+    printf("2. By CGPA (Descending)\n");
+    printf("3. By Name (A-Z)\n");
+    printf("4. Top K by CGPA\n");
+    printf("5. CGPA Range\n");
+    printf("Choose: ");
+    choice = readInt();
+
+    switch (choice) {
+        case 1:
+            printf("\n----- STUDENTS BY CGPA (ASCENDING) -----\n");
+            printSortedRange(&cgpaIndex, 0, cgpaIndex.count, 0);
+            break;
+        case 2:
+            printf("\n----- STUDENTS BY CGPA (DESCENDING) -----\n");
+            printSortedRange(&cgpaIndex, 0, cgpaIndex.count, 1);
+            break;
+        case 3:
+            printf("\n----- STUDENTS BY NAME (A-Z) -----\n");
+            printSortedRange(&nameIndex, 0, nameIndex.count, 0);
+            break;
+        case 4: {
+            printf("K: ");
+            long k = readInt();
+            if (k < 0) k = 0;
+            if (k > cgpaIndex.count) k = cgpaIndex.count;
+            printf("\n----- TOP %ld BY CGPA -----\n", k);
+            printSortedRange(&cgpaIndex, cgpaIndex.count - k, cgpaIndex.count, 1);
+            break;
+        }
+        case 5: {
+            printf("Minimum CGPA: ");
+            float lo = readFloat();
+            printf("Maximum CGPA: ");
+            float hi = readFloat();
+            long from = cgpaLowerBound(lo);
+            long to = from;
+            while (to < cgpaIndex.count && cgpaClamp(storeGet(cgpaIndex.recs[to])->cgpa) <= hi) to++;
+            printf("\n----- CGPA %.2f TO %.2f (%ld students) -----\n", lo, hi, to - from);
+            printSortedRange(&cgpaIndex, from, to, 0);
+            break;
+        }
+        default:
+            printf("Invalid choice.\n");
+            pauseScreen();
+            return;
+    }
+
+    pauseScreen();
+}
+
+#define SEARCH_SHOW 100
+
+/* Prefix or substring search over names, served by the trigram index. */
+void searchByName() {
+    char q[50];
+    int32_t *recs;
+
+    printf("\n----- SEARCH BY NAME -----\n");
+    printf("1. Name starts with\n");
+    printf("2. Name contains\n");
+    printf("Choose: ");
+    int mode = readInt();
+    if (mode != 1 && mode != 2) {
+        printf("Invalid choice.\n");
+        pauseScreen();
+        return;
+    }
+    printf("Search text: ");
+    readLine(q, sizeof(q));
+
+    double t0 = nowSeconds();
+    long n = triSearch(q, mode == 1, &recs);
+    double ms = (nowSeconds() - t0) * 1e3;
+    if (n < 0) {
+        printf("Out of memory.\n");
+        pauseScreen();
+        return;
+    }
+
+    printf("\n%ld match(es) in %.2f ms\n", n, ms);
+    for (long i = 0; i < n && i < SEARCH_SHOW; i++) printStudent(storeGet(recs[i]));
+    if (n > SEARCH_SHOW) printf("\n... and %ld more; refine the search to see them.\n", n - SEARCH_SHOW);
+    free(recs);
+    pauseScreen();
+}
+
+void compactStorage() {
+    if (!storeOpen(0)) {
+        printf("\nNo student file.\n");
+        pauseScreen();
+        return;
+    }
+
+    long reclaimed = studentsCompact();
+    if (reclaimed < 0) {
+        printf("\nCompaction failed.\n");
+    } else {
+        int64_t size, mtime;
+        storeStamp(&size, &mtime);
+        printf("\nReclaimed %ld deleted records. The store now takes %lld KiB.\n",
+               reclaimed, (long long)(size / 1024));
+    }
+    pauseScreen();
+}
+
+/* Export to any mix of CSV, TXT and JSON in one pass over the store. */
+void exportStudents() {
+    char choice[16];
+    unsigned formats = 0;
+
+    printf("\nFormats - any of c (CSV), t (TXT), j (JSON) [c]: ");
+    readLine(choice, sizeof(choice));
+    for (const char *p = choice; *p; p++) {
+        switch (tolower((unsigned char)*p)) {
+            case 'c': formats |= 1u << EXPORT_CSV; break;
+            case 't': formats |= 1u << EXPORT_TXT; break;
+            case 'j': formats |= 1u << EXPORT_JSON; break;
+        }
+    }
+    if (!formats) formats = 1u << EXPORT_CSV;
+
+    double t0 = nowSeconds();
+    long n = exportFiles(formats);
+    if (n < 0) {
+        printf("\nNothing exported.\n");
+    } else {
+        printf("\nExported %ld students to", n);
+        for (int f = 0; f < EXPORT_FORMAT_COUNT; f++)
+            if (formats & (1u << f)) printf(" %s", exportPaths[f]);
+        printf(" in %.3f s.\n", nowSeconds() - t0);
+    }
+    pauseScreen();
+}
+
+/* ---------- BULK IMPORT ---------- */
+
+/*
+ * Loads students from a CSV in the format autoExportCSV writes. The file
+ * is streamed row by row. Valid rows are batched and written about 1 MiB
+ * of encoded records at a time, and the indexes are rebuilt once at the
+ * end instead of being updated per row. The batch is sized by the encoded
+ * length, not sizeof(Student), since that is what reaches the disk.
+ */
+
+#define IMPORT_BATCH (CSV_BUF_SIZE / REC_TYPICAL)
+#define IMPORT_MAX_ERRORS_SHOWN 10
+
+typedef struct {
+    long rows;              /* data rows read */
+    long imported;
+    long rejected;
+    double seconds;
+} ImportResult;
+
+/* Copy src into a fixed-width field; fails if it does not fit. */
+int copyField(char *dst, size_t size, const char *src) {
+    size_t n = strlen(src);
+    if (n >= size) return 0;
+    memcpy(dst, src, n + 1);
+    return 1;
+}
+
+/* Parse one CSV row into s; returns NULL or the reason it was rejected. */
+const char *parseStudentRow(char *line, Student *s) {
+    char *f[6];
+    int n = 0;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    f[n++] = line;
+    for (char *p = line; *p; p++) {
+        if (*p == ',') {
+            if (n == 6) return "too many fields";
+            *p = '\0';
+            f[n++] = p + 1;
+        }
+    }
+    if (n != 6) return "expected 6 fields";
+
+    memset(s, 0, sizeof(Student));
+    if (f[0][0] == '\0') return "empty ID";
+    if (!copyField(s->id, sizeof(s->id), f[0])) return "ID too long";
+    if (!copyField(s->name, sizeof(s->name), f[1])) return "name too long";
+    if (!copyField(s->branch, sizeof(s->branch), f[2])) return "branch too long";
+    if (!copyField(s->section, sizeof(s->section), f[3])) return "section too long";
+    if (!copyField(s->phone, sizeof(s->phone), f[5])) return "phone too long";
+
+    char *end;
+    s->cgpa = strtof(f[4], &end);
+    if (end == f[4] || *end != '\0') return "CGPA is not a number";
+    if (!cgpaValid(s->cgpa)) return "CGPA out of range";
+
+    defaultPasswordOf(s->id, s->password, sizeof(s->password));
+    return NULL;
+}
+
+/* Set of IDs seen so far in one import, keyed by hashId. Each slot keeps
+   the ID itself so that two IDs with the same hash stay distinct. */
+typedef struct {
+    uint64_t hash;                      /* 0 marks an empty slot */
+    char id[20];
+} IdSetSlot;
+
+typedef struct {
+    IdSetSlot *slots;
+    uint32_t cap, used;
+} IdSet;
+
+/* Returns 1 if id was added, 0 if it was already there, -1 if out of memory. */
+int idSetAdd(IdSet *set, const char *id) {
+    uint64_t h = hashId(id);
+    if (h == 0) h = 1;
+    if ((set->used + 1) * 2 > set->cap) {
+        uint32_t cap = set->cap ? set->cap * 2 : 1024;
+        IdSetSlot *slots = (IdSetSlot *)calloc(cap, sizeof(IdSetSlot));
+        if (!slots) return -1;
+        for (uint32_t i = 0; i < set->cap; i++) {
+            if (!set->slots[i].hash) continue;
+            uint32_t j = (uint32_t)set->slots[i].hash & (cap - 1);
+            while (slots[j].hash) j = (j + 1) & (cap - 1);
+            slots[j] = set->slots[i];
+        }
+        free(set->slots);
+        set->slots = slots;
+        set->cap = cap;
+    }
+    uint32_t i = (uint32_t)h & (set->cap - 1);
+    while (set->slots[i].hash) {
+        if (set->slots[i].hash == h && strcmp(set->slots[i].id, id) == 0) return 0;
+        i = (i + 1) & (set->cap - 1);
+    }
+    set->slots[i].hash = h;
+    memcpy(set->slots[i].id, id, strnlen(id, sizeof(set->slots[i].id) - 1));
+    set->used++;
+    return 1;
+}
+
+/* Rebuild every index from the store in one pass each. */
+void indexesRebuild() {
+    for (size_t i = 0; i < DERIVED_INDEX_COUNT; i++)
+        derivedRebuild(derivedIndexes[i]);
+}
+
+int importCSV(const char *path, ImportResult *res, int verbose) {
+    char line[512];
+    Student *batch = NULL;
+    IdSet seen = { NULL, 0, 0 };
+    long inBatch = 0, lineNo = 0;
+    int ok = 1;
+
+    memset(res, 0, sizeof(*res));
+    FILE *in = fopen(path, "r");
+    if (!in) return 0;
+    setvbuf(in, NULL, _IOFBF, CSV_BUF_SIZE);
+
+    double start = nowSeconds();
+    if (!storeOpen(1) || !derivedEnsure(&idIndex) ||
+        !(batch = (Student *)malloc(sizeof(Student) * IMPORT_BATCH))) {
+        fclose(in);
+        free(batch);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), in)) {
+        lineNo++;
+        if (lineNo == 1 && strncmp(line, "ID,", 3) == 0) continue;
+        if (line[strspn(line, "\r\n")] == '\0') continue;
+        res->rows++;
+
+        Student *s = &batch[inBatch];
+        const char *err = parseStudentRow(line, s);
+        if (!err && idxHas(s->id)) err = "ID already exists";
+        if (!err) {
+            int added = idSetAdd(&seen, s->id);
+            if (added < 0) {
+                ok = 0;
+                break;
+            }
+            if (added == 0) err = "duplicate ID in file";
+        }
+        if (err) {
+            if (verbose && res->rejected < IMPORT_MAX_ERRORS_SHOWN)
+                printf("Line %ld rejected: %s\n", lineNo, err);
+            res->rejected++;
+            continue;
+        }
+
+        if (++inBatch == IMPORT_BATCH) {
+            if (storeAppendBatch(batch, inBatch) < 0) {
+                ok = 0;
+                break;
+            }
+            res->imported += inBatch;
+            inBatch = 0;
+        }
+    }
+    if (ok && inBatch > 0) {
+        if (storeAppendBatch(batch, inBatch) < 0) ok = 0;
+        else res->imported += inBatch;
+    }
+
+    fclose(in);
+    free(batch);
+    free(seen.slots);
+
+    if (res->imported > 0) {
+        indexesRebuild();
+        csvMarkStale();
+    }
+    res->seconds = nowSeconds() - start;
+    return ok;
+}
+
+void importStudents() {
+    char path[256];
+    ImportResult res;
+
+    printf("\n----- BULK IMPORT -----\n");
+    printf("CSV file [%s]: ", CSV_FILE);
+    readLine(path, sizeof(path));
+    if (path[0] == '\0') strcpy(path, CSV_FILE);
+
+    int ok = importCSV(path, &res, 1);
+    if (!ok && res.rows == 0) {
+        printf("\nCannot read %s.\n", path);
+        pauseScreen();
+        return;
+    }
+    if (!ok) printf("\nImport stopped early: write error.\n");
+    if (res.rejected > IMPORT_MAX_ERRORS_SHOWN)
+        printf("... %ld more rejected rows not shown.\n", res.rejected - IMPORT_MAX_ERRORS_SHOWN);
+
+    printf("\nRows read : %ld\n", res.rows);
+    printf("Imported  : %ld\n", res.imported);
+    printf("Rejected  : %ld\n", res.rejected);
+    printf("Time      : %.3f s (%.0f rows/sec)\n", res.seconds,
+           res.seconds > 0 ? (double)res.rows / res.seconds : 0.0);
+    pauseScreen();
+}
+
+/* ---------- TICKET STORE ---------- */
+
+/*
+ * tickets.dat starts with a header that holds the next ticket ID. IDs are
+ * handed out densely, so ticket N lives at a computed offset, and closing
+ * it is one in-place write of its status field. A file written before
+ * the header existed is migrated the first time it is opened.
+ *
+ * tickets.idx is a secondary index with one small entry per ticket: the
+ * hash of the student ID and an open flag. At load time it is turned into
+ * per-student chains and a list of open tickets, so "my tickets" and
+ * "open tickets" only read the tickets they return. Like students.idx, it
+ * is stamped with the data file's size and mtime and rebuilt if stale.
+ */
+
+#define TKT_MAGIC       0x31544B54u   /* "TKT1" */
+#define TKT_VERSION     1u
+#define TKT_IDX_FILE    "tickets.idx"
+#define TKT_IDX_MAGIC   0x58494B54u   /* "TKIX" */
+#define TKT_IDX_VERSION 1u
+#define TKT_OPEN        "OPEN"
+#define TKT_CLOSED      "CLOSED"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t  nextId;
+    int32_t  count;         /* ticket slots in the file */
+} TicketHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t  count;
+    int32_t  pad;
+    int64_t  dataSize;
+    int64_t  dataMtime;
+} TicketIdxHeader;
+
+typedef struct {
+    uint64_t sidHash;
+    int32_t  open;
+    int32_t  pad;
+} TicketIdxEntry;
+
+typedef struct {
+    uint64_t sidHash;
+    int head;               /* 0 = empty bucket */
+    int tail;
+} TicketBucket;
+
+static int             tktFd = -1;
+static TicketHeader    tktHdr;
+
+static TicketIdxHeader tidxHdr;
+static TicketIdxEntry *tidxEntries = NULL;  /* entry for ticket id i+1 */
+static int            *tidxNextSame = NULL; /* next ticket of the same student */
+static int            *tidxPrevOpen = NULL;
+static int            *tidxNextOpen = NULL;
+static int             tidxCap = 0;
+static int             tidxOpenHead = 0, tidxOpenTail = 0;
+static TicketBucket   *tidxBuckets = NULL;
+static uint32_t        tidxBucketCap = 0, tidxBucketUsed = 0;
+static int             tidxLoaded = 0;
+
+off_t ticketOffset(int id) {
+    return (off_t)sizeof(TicketHeader) + (off_t)(id - 1) * (off_t)sizeof(Ticket);
+}
+
+/* Rewrite a header-less tickets.dat into the current layout. */
+int ticketsMigrate() {
+    FILE *in = fopen(TKT_FILE, "rb");
+    if (!in) return 0;
+
+    Ticket *all = NULL, t;
+    int n = 0, cap = 0, maxId = 0;
+    while (fread(&t, sizeof(Ticket), 1, in) == 1) {
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            Ticket *grown = (Ticket *)realloc(all, sizeof(Ticket) * cap);
+            if (!grown) {
+                free(all);
+                fclose(in);
+                return 0;
+            }
+            all = grown;
+        }
+        all[n++] = t;
+        if (t.ticketId > maxId) maxId = t.ticketId;
+    }
+    fclose(in);
+
+    /* Slot i holds ticket i+1; gaps left by the old format stay zeroed. */
+    Ticket *slots = (Ticket *)calloc(maxId > 0 ? maxId : 1, sizeof(Ticket));
+    if (!slots) {
+        free(all);
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        int id = all[i].ticketId;
+        if (id > 0 && slots[id - 1].ticketId == 0) slots[id - 1] = all[i];
+    }
+    free(all);
+
+    TicketHeader h = { TKT_MAGIC, TKT_VERSION, maxId + 1, maxId };
+    FILE *out = fopen("tmp_tkt.dat", "wb");
+    int ok = out != NULL;
+    if (ok) {
+        fwrite(&h, sizeof(h), 1, out);
+        fwrite(slots, sizeof(Ticket), maxId, out);
+        ok = replaceFile(out, "tmp_tkt.dat", TKT_FILE);
+    }
+    free(slots);
+    if (!ok) perror("Cannot migrate ticket file");
+    return ok;
+}
+
+/* Open tickets.dat (creating it if asked) and load its header. */
+int ticketsOpen(int create) {
+    if (tktFd >= 0 && soleWriter) return 1;
+    if (tktFd < 0) {
+        struct stat st;
+        if (stat(TKT_FILE, &st) != 0) {
+            if (!create) return 0;
+        } else if (st.st_size >= (off_t)sizeof(uint32_t)) {
+            uint32_t magic = 0;
+            FILE *fp = fopen(TKT_FILE, "rb");
+            if (fp) {
+                if (fread(&magic, sizeof(magic), 1, fp) != 1) magic = 0;
+                fclose(fp);
+            }
+            if (magic != TKT_MAGIC && !ticketsMigrate()) return 0;
+        }
+
+        tktFd = open(TKT_FILE, O_RDWR | O_CREAT, 0644);
+        if (tktFd < 0) return 0;
+    }
+
+    if (!walRead(WAL_TICKETS, tktFd, &tktHdr, sizeof(tktHdr), 0)) {
+        TicketHeader h = { TKT_MAGIC, TKT_VERSION, 1, 0 };
+        tktHdr = h;
+        if (!walWrite(WAL_TICKETS, tktFd, &tktHdr, sizeof(tktHdr), 0) || !walFinish()) return 0;
+    }
+    return tktHdr.magic == TKT_MAGIC && tktHdr.version == TKT_VERSION;
+}
+
+void ticketsClose() {
+    if (tktFd >= 0) close(tktFd);
+    tktFd = -1;
+}
+
+int ticketGet(int id, Ticket *t) {
+    if (id < 1 || id > tktHdr.count) return 0;
+    if (!walRead(WAL_TICKETS, tktFd, t, sizeof(Ticket), ticketOffset(id))) return 0;
+    return t->ticketId == id;
+}
+
+/* ----- ticket index ----- */
+
+int tidxReserve(int count) {
+    if (count <= tidxCap) return 1;
+    int cap = tidxCap ? tidxCap : 64;
+    while (cap < count) cap *= 2;
+
+    TicketIdxEntry *e = (TicketIdxEntry *)realloc(tidxEntries, sizeof(*e) * cap);
+    if (e) tidxEntries = e;
+    int *ns = (int *)realloc(tidxNextSame, sizeof(int) * cap);
+    if (ns) tidxNextSame = ns;
+    int *po = (int *)realloc(tidxPrevOpen, sizeof(int) * cap);
+    if (po) tidxPrevOpen = po;
+    int *no = (int *)realloc(tidxNextOpen, sizeof(int) * cap);
+    if (no) tidxNextOpen = no;
+    if (!e || !ns || !po || !no) return 0;
+
+    tidxCap = cap;
+    return 1;
+}
+
+TicketBucket *tidxBucket(uint64_t h) {
+    uint32_t mask = tidxBucketCap - 1;
+    uint32_t i = (uint32_t)h & mask;
+    while (tidxBuckets[i].head != 0 && tidxBuckets[i].sidHash != h)
+        i = (i + 1) & mask;
+    return &tidxBuckets[i];
+}
+
+int tidxGrowBuckets() {
+    uint32_t oldCap = tidxBucketCap;
+    TicketBucket *old = tidxBuckets;
+    uint32_t cap = oldCap ? oldCap * 2 : 64;
+
+    tidxBuckets = (TicketBucket *)calloc(cap, sizeof(TicketBucket));
+    if (!tidxBuckets) {
+        tidxBuckets = old;
+        return 0;
+    }
+    tidxBucketCap = cap;
+    for (uint32_t i = 0; i < oldCap; i++)
+        if (old[i].head != 0) *tidxBucket(old[i].sidHash) = old[i];
+    free(old);
+    return 1;
+}
+
+void tidxLinkOpen(int id) {
+    tidxPrevOpen[id - 1] = tidxOpenTail;
+    tidxNextOpen[id - 1] = 0;
+    if (tidxOpenTail) tidxNextOpen[tidxOpenTail - 1] = id;
+    else tidxOpenHead = id;
+    tidxOpenTail = id;
+}
+
+void tidxUnlinkOpen(int id) {
+    int prev = tidxPrevOpen[id - 1], next = tidxNextOpen[id - 1];
+    if (prev) tidxNextOpen[prev - 1] = next;
+    else tidxOpenHead = next;
+    if (next) tidxPrevOpen[next - 1] = prev;
+    else tidxOpenTail = prev;
+}
+
+/* Add ticket id (its entry already filled in) to the in-memory lists. */
+void tidxLink(int id) {
+    const TicketIdxEntry *e = &tidxEntries[id - 1];
+    tidxNextSame[id - 1] = 0;
+    if (e->sidHash == 0) return;            /* unused slot */
+
+    if ((tidxBucketUsed + 1) * 2 > tidxBucketCap &&
+        !tidxGrowBuckets() && tidxBucketCap == 0)
+        return;
+    TicketBucket *b = tidxBucket(e->sidHash);
+    if (b->head == 0) {
+        b->sidHash = e->sidHash;
+        b->head = id;
+        tidxBucketUsed++;
+    } else {
+        tidxNextSame[b->tail - 1] = id;
+    }
+    b->tail = id;
+
+    if (e->open) tidxLinkOpen(id);
+}
+
+void tidxReset() {
+    free(tidxBuckets);
+    tidxBuckets = NULL;
+    tidxBucketCap = tidxBucketUsed = 0;
+    tidxOpenHead = tidxOpenTail = 0;
+    tidxLoaded = 0;
+}
+
+void tidxSave() {
+    FILE *fp = fopen(TKT_IDX_FILE, "wb");
+    if (!fp) return;
+    fwrite(&tidxHdr, sizeof(tidxHdr), 1, fp);
+    if (tidxHdr.count > 0) fwrite(tidxEntries, sizeof(TicketIdxEntry), tidxHdr.count, fp);
+    fclose(fp);
+}
+
+/* Persist one entry plus the restamped header. */
+void tidxSaveEntry(int id) {
+    fileStampOf(TKT_FILE, &tidxHdr.dataSize, &tidxHdr.dataMtime);
+    int fd = open(TKT_IDX_FILE, O_WRONLY);
+    if (fd < 0) {
+        tidxSave();
+        return;
+    }
+    if (pwrite(fd, &tidxHdr, sizeof(tidxHdr), 0) != (ssize_t)sizeof(tidxHdr) ||
+        pwrite(fd, &tidxEntries[id - 1], sizeof(TicketIdxEntry),
+               (off_t)sizeof(tidxHdr) + (off_t)(id - 1) * (off_t)sizeof(TicketIdxEntry))
+            != (ssize_t)sizeof(TicketIdxEntry)) {
+        close(fd);
+        tidxSave();
+        return;
+    }
+    close(fd);
+}
+
+/* Restamp the index after deferred log writes reached tickets.dat. */
+void tidxRestamp() {
+    if (!tidxLoaded) return;
+    fileStampOf(TKT_FILE, &tidxHdr.dataSize, &tidxHdr.dataMtime);
+    int fd = open(TKT_IDX_FILE, O_WRONLY);
+    if (fd < 0 || pwrite(fd, &tidxHdr, sizeof(tidxHdr), 0) != (ssize_t)sizeof(tidxHdr))
+        tidxSave();
+    if (fd >= 0) close(fd);
+}
+
+int tidxRebuild() {
+    tidxReset();
+    if (!tidxReserve(tktHdr.count)) return 0;
+
+    Ticket t;
+    for (int id = 1; id <= tktHdr.count; id++) {
+        TicketIdxEntry *e = &tidxEntries[id - 1];
+        memset(e, 0, sizeof(*e));
+        if (ticketGet(id, &t)) {
+            e->sidHash = hashId(t.studentId);
+            e->open = strcmp(t.status, TKT_CLOSED) != 0;
+        }
+        tidxLink(id);
+    }
+
+    tidxHdr.magic = TKT_IDX_MAGIC;
+    tidxHdr.version = TKT_IDX_VERSION;
+    tidxHdr.count = tktHdr.count;
+    tidxHdr.pad = 0;
+    fileStampOf(TKT_FILE, &tidxHdr.dataSize, &tidxHdr.dataMtime);
+    tidxSave();
+    tidxLoaded = 1;
+    return 1;
+}
+
+int tidxLoad() {
+    TicketIdxHeader h;
+    int64_t size, mtime;
+    FILE *fp = fopen(TKT_IDX_FILE, "rb");
+    if (!fp) return 0;
+
+    fileStampOf(TKT_FILE, &size, &mtime);
+    int ok = fread(&h, sizeof(h), 1, fp) == 1 &&
+             h.magic == TKT_IDX_MAGIC && h.version == TKT_IDX_VERSION &&
+             h.count == tktHdr.count && h.dataSize == size && h.dataMtime == mtime;
+    tidxReset();
+    if (ok) ok = tidxReserve(h.count) &&
+                 (h.count == 0 ||
+                  fread(tidxEntries, sizeof(TicketIdxEntry), h.count, fp) == (size_t)h.count);
+    fclose(fp);
+    if (!ok) return 0;
+
+    tidxHdr = h;
+    for (int id = 1; id <= h.count; id++) tidxLink(id);
+    tidxLoaded = 1;
+    return 1;
+}
+
+/* Open the ticket store and make sure the index matches it. */
+int ticketsReady(int create) {
+    if (!ticketsOpen(create)) return 0;
+    if (tidxLoaded && soleWriter) return 1;
+    if (tidxLoaded) {
+        int64_t size, mtime;
+        fileStampOf(TKT_FILE, &size, &mtime);
+        if (tidxHdr.count == tktHdr.count &&
+            size == tidxHdr.dataSize && mtime == tidxHdr.dataMtime)
+            return 1;
+    }
+    return tidxLoad() || tidxRebuild();
+}
+
+/* Raise a new open ticket; returns its ID or 0 on failure. */
+int ticketRaise(const char *sid, const char *message) {
+    if (!ticketsReady(1)) return 0;
+
+    Ticket t;
+    memset(&t, 0, sizeof(Ticket));
+    t.ticketId = tktHdr.nextId;
+    strncpy(t.studentId, sid, sizeof(t.studentId) - 1);
+    strncpy(t.message, message, sizeof(t.message) - 1);
+    strcpy(t.status, TKT_OPEN);
+
+    TicketHeader h = tktHdr;
+    h.nextId = t.ticketId + 1;
+    h.count = t.ticketId;
+    if (!tidxReserve(t.ticketId) ||
+        !walWrite(WAL_TICKETS, tktFd, &t, sizeof(Ticket), ticketOffset(t.ticketId)) ||
+        !walWrite(WAL_TICKETS, tktFd, &h, sizeof(h), 0) || !walFinish())
+        return 0;
+    tktHdr = h;
+
+    TicketIdxEntry *e = &tidxEntries[t.ticketId - 1];
+    memset(e, 0, sizeof(*e));
+    e->sidHash = hashId(t.studentId);
+    e->open = 1;
+    tidxLink(t.ticketId);
+    tidxHdr.count = tktHdr.count;
+    tidxSaveEntry(t.ticketId);
+    return t.ticketId;
+}
+
+/* Mark a ticket closed in place. Returns 1 if it was open, 0 if it was
+   already closed, -1 if there is no such ticket. */
+int ticketClose(int id) {
+    Ticket t;
+    if (!ticketsReady(0) || !ticketGet(id, &t)) return -1;
+    if (!tidxEntries[id - 1].open) return 0;
+
+    char status[sizeof(t.status)];
+    memset(status, 0, sizeof(status));
+    strcpy(status, TKT_CLOSED);
+    if (!walWrite(WAL_TICKETS, tktFd, status, sizeof(status),
+                  ticketOffset(id) + (off_t)offsetof(Ticket, status)) || !walFinish())
+        return -1;
+
+    tidxEntries[id - 1].open = 0;
+    tidxUnlinkOpen(id);
+    tidxSaveEntry(id);
+    return 1;
+}
+
+/* First ticket ID of a student (0 if none); follow with ticketNextOfStudent. */
+int ticketFirstOfStudent(const char *sid) {
+    if (!ticketsReady(0) || tidxBucketCap == 0) return 0;
+    return tidxBucket(hashId(sid))->head;
+}
+
+int ticketNextOfStudent(int id) {
+    return tidxNextSame[id - 1];
+}
+
+/* First open ticket ID (0 if none); follow with ticketNextOpen. */
+int ticketFirstOpen() {
+    if (!ticketsReady(0)) return 0;
+    return tidxOpenHead;
+}
+
+int ticketNextOpen(int id) {
+    return tidxNextOpen[id - 1];
+}
+
+/* ---------- TICKETS ---------- */
+
+void printTicket(const Ticket *t) {
+    printf("\nTicket ID: %d\nStudent ID: %s\nIssue: %s\nStatus: %s\n",
+           t->ticketId, t->studentId, t->message, t->status);
+}
+
+void raiseTicket(char sid[]) {
+    char message[200];
+
+    printf("\nEnter your concern: ");
+    readLine(message, sizeof(message));
+
+    int id = ticketRaise(sid, message);
+    if (id == 0) {
+        printf("Cannot open ticket file.\n");
+        pauseScreen();
+        return;
+    }
+
+    printf("\nTicket raised. ID: %d\n", id);
+    pauseScreen();
+}
+
+/* Print the tickets of one student, oldest first. */
+int printStudentTickets(const char *sid) {
+    Ticket t;
+    int n = 0;
+    for (int id = ticketFirstOfStudent(sid); id; id = ticketNextOfStudent(id)) {
+        if (ticketGet(id, &t) && strcmp(t.studentId, sid) == 0) {
+            printTicket(&t);
+            n++;
+        }
+    }
+    return n;
+}
+
+void viewTickets() {
+    Ticket t;
+    char sid[20];
+    int n = 0;
+
+    if (!ticketsReady(0)) {
+        printf("No tickets.\n");
+        pauseScreen();
+        return;
+    }
+
+    printf("\n----- VIEW TICKETS -----\n");
+    printf("1. All Tickets\n");
+    printf("2. Open Tickets\n");
+    printf("3. Tickets of a Student\n");
     printf("Choose: ");
-    choice = readInt();
 
-    switch (choice) {
+    switch (readInt()) {
         case 1:
-            qsort(arr, n, sizeof(Student), cmpCgpaAsc);
-            printf("\nSorted by CGPA (Ascending).\n");
+            printf("\n----- ALL TICKETS -----\n");
+            for (int id = 1; id < tktHdr.nextId; id++) {
+                if (ticketGet(id, &t)) {
+                    printTicket(&t);
+                    n++;
+                }
+            }
             break;
         case 2:
-            qsort(arr, n, sizeof(Student), cmpCgpaDesc);
-            printf("\nSorted by CGPA (Descending).\n");
+            printf("\n----- OPEN TICKETS -----\n");
+            for (int id = ticketFirstOpen(); id; id = ticketNextOpen(id)) {
+                if (ticketGet(id, &t)) {
+                    printTicket(&t);
+                    n++;
+                }
+            }
             break;
         case 3:
-            qsort(arr, n, sizeof(Student), cmpNameAsc);
-            printf("\nSorted by Name (A-Z).\n");
+            printf("Student ID: ");
+            readLine(sid, sizeof(sid));
+            printf("\n----- TICKETS OF %s -----\n", sid);
+            n = printStudentTickets(sid);
             break;
         default:
             printf("Invalid choice.\n");
@@ -467,176 +4364,919 @@ void sortStudentsMenu() {
             return;
     }
 
-    saveAllStudents(arr, n);
-    autoExportCSV();
-    printf("CSV updated automatically.\n");
-
-    printf("\n----- STUDENTS AFTER SORTING -----\n");
-    for (int i = 0; i < n; i++) {
-        printf("\nID: %s\nName: %s\nBranch: %s\nSection: %s\nCGPA: %.2f\nPhone: %s\n",
-               arr[i].id, arr[i].name, arr[i].branch, arr[i].section, arr[i].cgpa, arr[i].phone);
-    }
-
+    if (n == 0) printf("\nNo tickets.\n");
     pauseScreen();
 }
 
-void exportToCSV() {
-    autoExportCSV();
-    Student arr[MAX_STUDENTS];
-    int n = loadAllStudents(arr, MAX_STUDENTS);
-    printf("\nExported %d students to %s\n", n, CSV_FILE);
-    pauseScreen();
-}
+void closeTicket() {
+    int tid;
 
-/* ---------- TICKETS ---------- */
+    if (!ticketsReady(0)) {
+        printf("Error opening ticket files.\n");
+        pauseScreen();
+        return;
+    }
 
-int nextTicketId() {
-    Ticket t;
-    int max = 0;
-    FILE *fp = fopen(TKT_FILE, "rb");
-    if (!fp) return 1;
+    printf("\nEnter Ticket ID to close: ");
+    tid = readInt();
 
-    while (fread(&t, sizeof(Ticket), 1, fp) == 1) {
-        if (t.ticketId > max) max = t.ticketId;
+    switch (ticketClose(tid)) {
+        case 1:  printf("\nTicket closed.\n"); break;
+        case 0:  printf("\nTicket is already closed.\n"); break;
+        default: printf("\nTicket not found.\n"); break;
     }
 
-    fclose(fp);
-    return max + 1;
+    pauseScreen();
 }
 
-void raiseTicket(char sid[]) {
-    Ticket t;
-    memset(&t, 0, sizeof(Ticket));
-    FILE *fp = fopen(TKT_FILE, "ab");
-    if (!fp) {
-        printf("Cannot open ticket file.\n");
+/* ---------- STUDENT SIDE ---------- */
+
+void viewMyDetails(StudentSession *me) {
+    const Student *s = sessionStudent(me);
+    if (!s) {
+        printf("Your record no longer exists.\n");
         pauseScreen();
         return;
     }
 
-    t.ticketId = nextTicketId();
-    strcpy(t.studentId, sid);
-    strcpy(t.status, "OPEN");
-
-    printf("\nEnter your concern: ");
-    readLine(t.message, sizeof(t.message));
+    printf("\n----- MY DETAILS -----\n");
+    printf("ID: %s\nName: %s\nBranch: %s\nSection: %s\nCGPA: %.2f\nPhone: %s\n",
+           s->id, s->name, s->branch, s->section, s->cgpa, s->phone);
 
-    fwrite(&t, sizeof(Ticket), 1, fp);
-    fclose(fp);
+    pauseScreen();
+}
 
-    printf("\nTicket raised. ID: %d\n", t.ticketId);
+void viewMyTickets(char sid[]) {
+    printf("\n----- MY TICKETS -----\n");
+    if (printStudentTickets(sid) == 0) printf("\nNo tickets.\n");
     pauseScreen();
 }
 
-void viewTickets() {
-    Ticket t;
-    FILE *fp = fopen(TKT_FILE, "rb");
-    if (!fp) {
-        printf("No tickets.\n");
+void changePassword(StudentSession *me) {
+    if (!sessionStudent(me)) {
+        printf("Your record no longer exists.\n");
         pauseScreen();
         return;
     }
 
-    printf("\n----- ALL TICKETS -----\n");
+    char newPass[20];
 
-    while (fread(&t, sizeof(Ticket), 1, fp) == 1) {
-        printf("\nTicket ID: %d\nStudent ID: %s\nIssue: %s\nStatus: %s\n",
-               t.ticketId, t.studentId, t.message, t.status);
-    }
+    printf("\nEnter new password: ");
+    readLine(newPass, sizeof(newPass));
 
-    fclose(fp);
+    const char *err = opSetSessionPassword(me, newPass);
+    if (err) printf("Password not changed: %s.\n", err);
+    else printf("Password updated.\n");
     pauseScreen();
 }
 
-void closeTicket() {
-    int tid, found = 0;
+/* ---------- SERVER MODE ---------- */
+
+/*
+ * `srms --serve [socket] [--threads N]` serves the same operations over a
+ * Unix domain socket so many people can use SRMS at once. The main thread
+ * poll()s the listening socket and every idle connection. A connection
+ * with input waiting goes on a queue; a worker thread takes it, serves
+ * one request and hands it back to be polled again. A worker is only
+ * tied up while a request runs, so any number of logged-in clients can
+ * sit idle between requests. Reads (login, details, ticket listings)
+ * share a reader-writer lock, and writes hold it exclusively. The server is the only process with the
+ * database open (see LOCK_FILE), so it loads every index once at startup
+ * and skips the per-call freshness checks after that.
+ *
+ * A write is acknowledged only once its log record is on disk.
+ *
+ * Protocol: one request per line, fields separated by tabs. Replies are
+ * "OK[\t...]" or "ERR\t<reason>"; a listing is "OK\t<n>" followed by n
+ * lines.
+ *
+ *   LOGIN id pass          ADMIN user pass          LOGOUT      QUIT
+ *   DETAILS [id]           PASSWD new               TICKET message
+ *   MYTICKETS              TICKETS OPEN|ALL|<id>    CLOSE ticketId
+ *   ADD id name branch section cgpa phone           DELETE id
+ *   UPDATE id name branch section cgpa phone        CHID old new
+ */
+
+#define SOCK_PATH      "srms.sock"
+#define SERVER_THREADS 8
+#define SERVER_MAXCONNS 1000          /* open connections; stays under the usual fd limit */
+#define SERVER_MAXARGS 8
+#define SERVER_LINE    512
+
+typedef struct {
+    int admin;
+    StudentSession me;            /* me.sid is empty unless a student is logged in */
+} Session;
+
+/* One client connection. It is either polled by the main thread or
+   queued for, or held by, exactly one worker. */
+typedef struct {
+    int fd;                       /* -1 once a worker has closed it */
+    Session ss;
+    char in[SERVER_LINE];         /* bytes read but not yet handled */
+    size_t inLen;
+} Conn;
+
+/* Holds every connection at most once, so it can never fill up. */
+typedef struct {
+    Conn *items[SERVER_MAXCONNS];
+    int head, count;
+    pthread_mutex_t mu;
+    pthread_cond_t notEmpty;
+} ConnQueue;
+
+typedef struct {
+    char *buf;
+    size_t len, cap;
+} Reply;
+
+static pthread_rwlock_t dbLock = PTHREAD_RWLOCK_INITIALIZER;
+static ConnQueue readyConns = { { 0 }, 0, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+static ConnQueue doneConns = { { 0 }, 0, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+static int wakeFds[2] = { -1, -1 };      /* wakes the poll loop when doneConns grows */
+static volatile sig_atomic_t serverStop = 0;
+
+static const char ERR_SYNC[] = "cannot sync write-ahead log";
+
+/* End a write: release the lock first, then wait for the log to reach
+   disk, so writers that finish while an fsync runs share the next one.
+   Only then do the data files get the write. */
+int dbWriteDone() {
+    uint64_t lsn = walLastLsn();
+    pthread_rwlock_unlock(&dbLock);
+    int ok = walCommit(lsn);
+    return walApplySynced() && ok;
+}
+
+/* Apply every deferred write and restamp the indexes, which were stamped
+   while those writes were still queued. */
+int dbSettle() {
+    if (!walCheckpoint()) return 0;
+    indexesRestamp();
+    tidxRestamp();
+    return 1;
+}
+
+void connPush(ConnQueue *q, Conn *c) {
+    pthread_mutex_lock(&q->mu);
+    q->items[(q->head + q->count) % SERVER_MAXCONNS] = c;
+    q->count++;
+    pthread_cond_signal(&q->notEmpty);
+    pthread_mutex_unlock(&q->mu);
+}
+
+/* Take the oldest connection; waits for one if wait is set, otherwise
+   returns NULL when the queue is empty. */
+Conn *connPop(ConnQueue *q, int wait) {
+    Conn *c = NULL;
+    pthread_mutex_lock(&q->mu);
+    while (wait && q->count == 0)
+        pthread_cond_wait(&q->notEmpty, &q->mu);
+    if (q->count > 0) {
+        c = q->items[q->head];
+        q->head = (q->head + 1) % SERVER_MAXCONNS;
+        q->count--;
+    }
+    pthread_mutex_unlock(&q->mu);
+    return c;
+}
+
+void replyf(Reply *r, const char *fmt, ...) {
+    va_list ap;
+    while (1) {
+        va_start(ap, fmt);
+        int n = vsnprintf(r->buf + r->len, r->cap - r->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if (r->len + (size_t)n < r->cap) {
+            r->len += (size_t)n;
+            return;
+        }
+        size_t cap = r->cap * 2;
+        while (cap <= r->len + (size_t)n) cap *= 2;
+        char *buf = (char *)realloc(r->buf, cap);
+        if (!buf) return;
+        r->buf = buf;
+        r->cap = cap;
+    }
+}
+
+/* Copy a stored field into a reply, keeping tabs and newlines out of it. */
+const char *wireField(char *dst, const char *src, size_t max) {
+    size_t i = 0;
+    for (; i < max && src[i]; i++)
+        dst[i] = (src[i] == '\t' || src[i] == '\n' || src[i] == '\r') ? ' ' : src[i];
+    dst[i] = '\0';
+    return dst;
+}
+
+void replyStudent(Reply *r, const Student *s) {
+    char id[20], name[50], branch[20], section[10], phone[15];
+    replyf(r, "OK\t%s\t%s\t%s\t%s\t%.2f\t%s\n",
+           wireField(id, s->id, sizeof(id) - 1),
+           wireField(name, s->name, sizeof(name) - 1),
+           wireField(branch, s->branch, sizeof(branch) - 1),
+           wireField(section, s->section, sizeof(section) - 1),
+           s->cgpa,
+           wireField(phone, s->phone, sizeof(phone) - 1));
+}
+
+void replyTicketLine(Reply *r, const Ticket *t) {
+    char sid[20], status[10], message[200];
+    replyf(r, "%d\t%s\t%s\t%s\n", t->ticketId,
+           wireField(sid, t->studentId, sizeof(sid) - 1),
+           wireField(status, t->status, sizeof(status) - 1),
+           wireField(message, t->message, sizeof(message) - 1));
+}
+
+/* Reply with the tickets selected by which: "OPEN", "ALL" or a student ID. */
+void replyTickets(Reply *r, const char *which) {
     Ticket t;
-    FILE *fp = fopen(TKT_FILE, "rb");
-    FILE *tmp = fopen("tmp_tkt.dat", "wb");
+    Reply body = { NULL, 0, 1024 };
+    int n = 0;
 
-    if (!fp || !tmp) {
-        printf("Error opening ticket files.\n");
-        if (fp) fclose(fp);
-        if (tmp) fclose(tmp);
-        pauseScreen();
+    if (!(body.buf = (char *)malloc(body.cap))) {
+        replyf(r, "ERR\tout of memory\n");
         return;
     }
 
-    printf("\nEnter Ticket ID to close: ");
-    tid = readInt();
+    if (strcmp(which, "ALL") == 0) {
+        int last = ticketsReady(0) ? tktHdr.nextId : 1;
+        for (int id = 1; id < last; id++)
+            if (ticketGet(id, &t)) { replyTicketLine(&body, &t); n++; }
+    } else if (strcmp(which, "OPEN") == 0) {
+        for (int id = ticketFirstOpen(); id; id = ticketNextOpen(id))
+            if (ticketGet(id, &t)) { replyTicketLine(&body, &t); n++; }
+    } else {
+        for (int id = ticketFirstOfStudent(which); id; id = ticketNextOfStudent(id))
+            if (ticketGet(id, &t) && strcmp(t.studentId, which) == 0) {
+                replyTicketLine(&body, &t);
+                n++;
+            }
+    }
+
+    replyf(r, "OK\t%d\n", n);
+    replyf(r, "%.*s", (int)body.len, body.buf);
+    free(body.buf);
+}
 
-    while (fread(&t, sizeof(Ticket), 1, fp) == 1) {
-        if (t.ticketId == tid) {
-            strcpy(t.status, "CLOSED");
-            found = 1;
+/* Parse ADD/UPDATE arguments (id name branch section cgpa phone). */
+const char *parseStudentArgs(char **argv, Student *s) {
+    char *end;
+    memset(s, 0, sizeof(Student));
+    if (!copyField(s->id, sizeof(s->id), argv[0]) || s->id[0] == '\0') return "bad ID";
+    if (!copyField(s->name, sizeof(s->name), argv[1])) return "name too long";
+    if (!copyField(s->branch, sizeof(s->branch), argv[2])) return "branch too long";
+    if (!copyField(s->section, sizeof(s->section), argv[3])) return "section too long";
+    s->cgpa = strtof(argv[4], &end);
+    if (end == argv[4] || *end != '\0') return "CGPA is not a number";
+    if (!cgpaValid(s->cgpa)) return "CGPA out of range";
+    if (!copyField(s->phone, sizeof(s->phone), argv[5])) return "phone too long";
+    return NULL;
+}
+
+/* Handle one request; returns 0 when the connection should close. */
+int handleRequest(Session *ss, char *line, Reply *r) {
+    char *argv[SERVER_MAXARGS + 1];
+    int argc = 0;
+    const char *err = NULL;
+    Student s;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    argv[argc++] = line;
+    for (char *p = line; *p && argc <= SERVER_MAXARGS; p++) {
+        if (*p == '\t') {
+            *p = '\0';
+            argv[argc++] = p + 1;
         }
-        fwrite(&t, sizeof(Ticket), 1, tmp);
     }
+    const char *cmd = argv[0];
+    argc--;                              /* number of arguments */
 
-    fclose(fp);
-    fclose(tmp);
+#define NEED(n) if (argc != (n)) { replyf(r, "ERR\tusage\n"); return 1; }
+#define NEED_STUDENT if (!ss->me.sid[0]) { replyf(r, "ERR\tnot logged in\n"); return 1; }
+#define NEED_ADMIN if (!ss->admin) { replyf(r, "ERR\tadmin only\n"); return 1; }
 
-    remove(TKT_FILE);
-    rename("tmp_tkt.dat", TKT_FILE);
+    if (strcmp(cmd, "QUIT") == 0) {
+        replyf(r, "OK\n");
+        return 0;
+    } else if (strcmp(cmd, "LOGIN") == 0) {
+        NEED(2);
+        pthread_rwlock_rdlock(&dbLock);
+        int ok = sessionBegin(&ss->me, argv[1], argv[2]);
+        pthread_rwlock_unlock(&dbLock);
+        if (!ok) err = "invalid credentials";
+        else ss->admin = 0;
+    } else if (strcmp(cmd, "ADMIN") == 0) {
+        NEED(2);
+        if (!authAdmin(argv[1], argv[2])) err = "invalid credentials";
+        else {
+            ss->admin = 1;
+            ss->me.sid[0] = '\0';
+        }
+    } else if (strcmp(cmd, "LOGOUT") == 0) {
+        memset(ss, 0, sizeof(*ss));
+    } else if (strcmp(cmd, "DETAILS") == 0) {
+        if (ss->admin) {
+            NEED(1);
+        } else {
+            NEED_STUDENT;
+            NEED(0);
+        }
+        pthread_rwlock_rdlock(&dbLock);
+        const Student *v = ss->admin ? lookupStudent(argv[1], NULL) : sessionStudent(&ss->me);
+        if (v) replyStudent(r, v);
+        pthread_rwlock_unlock(&dbLock);
+        if (!v) err = ERR_NOTFOUND;
+        else return 1;
+    } else if (strcmp(cmd, "PASSWD") == 0) {
+        NEED_STUDENT;
+        NEED(1);
+        pthread_rwlock_wrlock(&dbLock);
+        err = opSetSessionPassword(&ss->me, argv[1]);
+        if (!dbWriteDone() && !err) err = ERR_SYNC;
+    } else if (strcmp(cmd, "TICKET") == 0) {
+        NEED_STUDENT;
+        NEED(1);
+        pthread_rwlock_wrlock(&dbLock);
+        int id = ticketRaise(ss->me.sid, argv[1]);
+        if (!dbWriteDone()) id = 0;
+        if (id == 0) err = "cannot write ticket file";
+        else {
+            replyf(r, "OK\t%d\n", id);
+            return 1;
+        }
+    } else if (strcmp(cmd, "MYTICKETS") == 0 || strcmp(cmd, "TICKETS") == 0) {
+        const char *which = ss->me.sid;
+        if (cmd[0] == 'M') {
+            NEED_STUDENT;
+            NEED(0);
+        } else {
+            NEED_ADMIN;
+            NEED(1);
+            which = argv[1];
+        }
+        pthread_rwlock_rdlock(&dbLock);
+        replyTickets(r, which);
+        pthread_rwlock_unlock(&dbLock);
+        return 1;
+    } else if (strcmp(cmd, "CLOSE") == 0) {
+        NEED_ADMIN;
+        NEED(1);
+        pthread_rwlock_wrlock(&dbLock);
+        int rc = ticketClose(atoi(argv[1]));
+        int synced = dbWriteDone();
+        if (rc == 0) err = "ticket already closed";
+        else if (rc < 0) err = "ticket not found";
+        else if (!synced) err = ERR_SYNC;
+    } else if (strcmp(cmd, "ADD") == 0 || strcmp(cmd, "UPDATE") == 0) {
+        NEED_ADMIN;
+        NEED(6);
+        err = parseStudentArgs(argv + 1, &s);
+        if (!err) {
+            pthread_rwlock_wrlock(&dbLock);
+            err = cmd[0] == 'A' ? opAddStudent(&s) : opUpdateStudent(&s);
+            if (!dbWriteDone() && !err) err = ERR_SYNC;
+            if (!err && cmd[0] == 'A') {
+                replyf(r, "OK\t%s\n", s.password);
+                return 1;
+            }
+        }
+    } else if (strcmp(cmd, "DELETE") == 0) {
+        NEED_ADMIN;
+        NEED(1);
+        pthread_rwlock_wrlock(&dbLock);
+        err = opDeleteStudent(argv[1]);
+        if (!dbWriteDone() && !err) err = ERR_SYNC;
+    } else if (strcmp(cmd, "CHID") == 0) {
+        NEED_ADMIN;
+        NEED(2);
+        pthread_rwlock_wrlock(&dbLock);
+        err = opChangeStudentId(argv[1], argv[2]);
+        if (!dbWriteDone() && !err) err = ERR_SYNC;
+    } else {
+        err = "unknown command";
+    }
 
-    if (found) printf("\nTicket closed.\n");
-    else printf("\nTicket not found.\n");
+#undef NEED
+#undef NEED_STUDENT
+#undef NEED_ADMIN
 
-    pauseScreen();
+    if (err) replyf(r, "ERR\t%s\n", err);
+    else replyf(r, "OK\n");
+    return 1;
 }
 
-/* ---------- STUDENT SIDE ---------- */
+/* Length of the first complete request line buffered in c, or 0. A line
+   that fills the whole buffer is served as it is, like fgets() would. */
+size_t connLineLen(const Conn *c) {
+    const char *nl = (const char *)memchr(c->in, '\n', c->inLen);
+    if (nl) return (size_t)(nl - c->in) + 1;
+    return c->inLen == sizeof(c->in) - 1 ? c->inLen : 0;
+}
 
-void viewMyDetails(char sid[]) {
-    Student s;
-    FILE *fp = fopen(STUD_FILE, "rb");
-    if (!fp) {
-        printf("No student file.\n");
-        pauseScreen();
-        return;
+/* Serve at most one request from c, reading first if none is buffered.
+   Returns 0 when the connection should be closed. */
+int serveRequest(Conn *c, Reply *r) {
+    char line[SERVER_LINE];
+    size_t n = connLineLen(c);
+    if (n == 0) {
+        ssize_t got = read(c->fd, c->in + c->inLen, sizeof(c->in) - 1 - c->inLen);
+        if (got < 0 && (errno == EINTR || errno == EAGAIN)) return 1;
+        if (got <= 0) return 0;
+        c->inLen += (size_t)got;
+        if ((n = connLineLen(c)) == 0) return 1;      /* wait for the rest */
+    }
+
+    memcpy(line, c->in, n);
+    line[n] = '\0';
+    c->inLen -= n;
+    memmove(c->in, c->in + n, c->inLen);
+
+    r->len = 0;
+    int more = handleRequest(&c->ss, line, r);
+    return writeAll(c->fd, r->buf, r->len) && more;
+}
+
+void *serverWorker(void *arg) {
+    Reply r = { NULL, 0, 1024 };
+    (void)arg;
+    if (!(r.buf = (char *)malloc(r.cap))) return NULL;
+    while (1) {
+        Conn *c = connPop(&readyConns, 1);
+        if (!serveRequest(c, &r)) {
+            close(c->fd);
+            c->fd = -1;
+        } else if (connLineLen(c) > 0) {
+            connPush(&readyConns, c);       /* pipelined request: no need to poll */
+            continue;
+        }
+        connPush(&doneConns, c);
+        if (write(wakeFds[1], "", 1) < 0 && errno != EAGAIN)
+            perror("Cannot wake the poll loop");
     }
+    return NULL;
+}
 
-    while (fread(&s, sizeof(Student), 1, fp) == 1) {
-        if (strcmp(s.id, sid) == 0) {
-            printf("\n----- MY DETAILS -----\n");
-            printf("ID: %s\nName: %s\nBranch: %s\nSection: %s\nCGPA: %.2f\nPhone: %s\n",
-                   s.id, s.name, s.branch, s.section, s.cgpa, s.phone);
+void onServerSignal(int sig) {
+    (void)sig;
+    serverStop = 1;
+}
+
+/* The poll loop: watches the listening socket and every idle connection,
+   and queues a connection for the workers once it has input. Runs until
+   a shutdown signal arrives. */
+void serverPoll(int lfd) {
+    static struct pollfd pfds[2 + SERVER_MAXCONNS];
+    static Conn *idle[SERVER_MAXCONNS];
+    int nIdle = 0, open = 0;
+
+    while (!serverStop) {
+        pfds[0].fd = open < SERVER_MAXCONNS ? lfd : -1;   /* full: leave new ones in the backlog */
+        pfds[0].events = POLLIN;
+        pfds[1].fd = wakeFds[0];
+        pfds[1].events = POLLIN;
+        for (int i = 0; i < nIdle; i++) {
+            pfds[2 + i].fd = idle[i]->fd;
+            pfds[2 + i].events = POLLIN;
+        }
+        if (poll(pfds, (nfds_t)(2 + nIdle), -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
             break;
         }
+
+        /* Walk backwards so a swap-remove never skips an entry. */
+        for (int i = nIdle - 1; i >= 0; i--) {
+            if (!pfds[2 + i].revents) continue;
+            connPush(&readyConns, idle[i]);
+            idle[i] = idle[--nIdle];
+            pfds[2 + i].revents = pfds[2 + nIdle].revents;
+        }
+
+        if (pfds[1].revents) {
+            char buf[256];
+            Conn *c;
+            while (read(wakeFds[0], buf, sizeof(buf)) > 0) ;
+            while ((c = connPop(&doneConns, 0)) != NULL) {
+                if (c->fd < 0) {
+                    free(c);
+                    open--;
+                } else {
+                    idle[nIdle++] = c;
+                }
+            }
+        }
+
+        while (pfds[0].revents && open < SERVER_MAXCONNS) {
+            int cfd = accept(lfd, NULL, NULL);
+            if (cfd < 0) {
+                if (errno != EAGAIN && errno != EINTR) perror("accept");
+                break;
+            }
+            Conn *c = (Conn *)calloc(1, sizeof(Conn));
+            if (!c) {
+                close(cfd);
+                break;
+            }
+            c->fd = cfd;
+            idle[nIdle++] = c;
+            open++;
+        }
     }
+}
 
-    fclose(fp);
-    pauseScreen();
+int serveMain(const char *path, int threads) {
+    struct sockaddr_un addr;
+    struct sigaction sa;
+    sigset_t block, old;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+
+    /* Load everything up front; from here on this process is the only
+       writer, so the freshness checks can be skipped. */
+    if (!storeOpen(1) || !indexesPrepare() || !ticketsReady(1)) {
+        fprintf(stderr, "Cannot open the student database.\n");
+        return 1;
+    }
+    storeDecodeAll();
+    soleWriter = 1;
+    wal.autoCommit = 0;                     /* see dbWriteDone() */
+
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        perror("socket");
+        return 1;
+    }
+    unlink(path);
+    if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(lfd, SOMAXCONN) != 0) {
+        perror("Cannot listen on socket");
+        close(lfd);
+        return 1;
+    }
+
+    /* The poll loop must never block on accept() or on draining the
+       wake-up pipe, and a worker must never block waking it. */
+    if (pipe(wakeFds) != 0) {
+        perror("pipe");
+        close(lfd);
+        return 1;
+    }
+    fcntl(lfd, F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onServerSignal;         /* no SA_RESTART: poll() returns */
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Workers never take the shutdown signals. */
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    for (int i = 0; i < threads; i++) {
+        pthread_t t;
+        if (pthread_create(&t, NULL, serverWorker, NULL) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+        pthread_detach(t);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    printf("SRMS server listening on %s with %d worker threads.\n", path, threads);
+    fflush(stdout);
+
+    serverPoll(lfd);
+
+    close(lfd);
+    unlink(path);
+    pthread_rwlock_wrlock(&dbLock);
+    dbSettle();
+    sessionFlush();
+    printf("SRMS server stopped.\n");
+    return 0;
+}
+
+/* ---------- BENCHMARK ---------- */
+
+/*
+ * `srms --bench [--students N] [--tickets N] [--ops N] [--mix spec]
+ * [--seed S] [--keep]` builds a synthetic database in a fresh temporary
+ * directory. It then drives a random mix of operations through the same
+ * functions the menus and the server call, and reports p50/p99/max
+ * latency and throughput per operation. The mix is a comma-separated
+ * list of op=weight pairs, e.g. "login=50,update=10,export=0"; ops that
+ * are not listed keep their default weight. The directory is removed
+ * afterwards unless --keep is given.
+ */
+
+#define BENCH_STUDENTS 100000
+#define BENCH_TICKETS  20000
+#define BENCH_OPS      10000
+#define BENCH_BATCH    4096
+#define BENCH_TICKET_BATCH 256     /* tickets per log sync; bounds the walRead() overlay */
+#define BENCH_TOP_K    10
+
+enum {
+    BENCH_LOGIN, BENCH_LOOKUP, BENCH_UPDATE, BENCH_DELETE,
+    BENCH_RAISE, BENCH_CLOSE, BENCH_SORT, BENCH_EXPORT, BENCH_OP_COUNT
+};
+
+static const char *const benchOpNames[BENCH_OP_COUNT] = {
+    "login", "lookup", "update", "delete", "raise", "close", "sort", "export"
+};
+static const int benchDefaultMix[BENCH_OP_COUNT] = { 30, 30, 15, 2, 10, 8, 4, 1 };
+
+typedef struct {
+    long students, tickets, ops;
+    uint64_t seed;
+    int keep;
+    int mix[BENCH_OP_COUNT];
+} BenchConfig;
+
+typedef struct {
+    double *lat;                  /* seconds, one per call */
+    long count, cap, failed;
+    double total;
+} BenchStat;
+
+typedef struct {
+    uint64_t rng;
+    char (*ids)[20];              /* IDs still live, for picking targets */
+    long live;
+    long nextId;                  /* suffix of the next generated ID */
+    BenchStat stats[BENCH_OP_COUNT];
+} Bench;
+
+/* xorshift64*: fast, seedable, and plenty for picking workload targets. */
+uint64_t benchRand(Bench *b) {
+    b->rng ^= b->rng >> 12;
+    b->rng ^= b->rng << 25;
+    b->rng ^= b->rng >> 27;
+    return b->rng * 0x2545F4914F6CDD1DULL;
+}
+
+long benchPick(Bench *b, long n) {
+    return (long)(benchRand(b) % (uint64_t)n);
+}
+
+void benchStudent(Bench *b, Student *s) {
+    static const char *const first[] = { "Aarav", "Priya", "Rohan", "Sneha", "Karthik",
+                                         "Meera", "Arjun", "Divya", "Rahul", "Kavya" };
+    static const char *const last[] = { "Sharma", "Iyer", "Reddy", "Nair", "Gupta",
+                                        "Patel", "Singh", "Rao", "Menon", "Joshi" };
+    static const char *const branch[] = { "CSE", "ECE", "ME", "EEE", "CIVIL" };
+    static const char *const section[] = { "A", "B", "C" };
+
+    memset(s, 0, sizeof(*s));
+    snprintf(s->id, sizeof(s->id), "B%07ld", b->nextId++);
+    snprintf(s->name, sizeof(s->name), "%s %c %s", first[benchPick(b, 10)],
+             'A' + (int)benchPick(b, 26), last[benchPick(b, 10)]);
+    strcpy(s->branch, branch[benchPick(b, 5)]);
+    strcpy(s->section, section[benchPick(b, 3)]);
+    s->cgpa = 5.0f + (float)benchPick(b, 501) / 100.0f;
+    snprintf(s->phone, sizeof(s->phone), "9%09ld", benchPick(b, 1000000000L));
+    setDefaultPassword(s);
+}
+
+/* Create the synthetic students and tickets. Logging is batched here;
+   the measured operations commit once per operation as usual. */
+int benchPopulate(Bench *b, const BenchConfig *cfg) {
+    Student *batch = (Student *)malloc(sizeof(Student) * BENCH_BATCH);
+    b->ids = (char (*)[20])malloc(sizeof(*b->ids) * (size_t)(cfg->students > 0 ? cfg->students : 1));
+    if (!batch || !b->ids || !storeOpen(1)) {
+        free(batch);
+        return 0;
+    }
+
+    /* Log records are synced once per batch rather than once per write.
+       Every batch is applied before the next one starts, so walRead()
+       never has more than one batch of queued writes to overlay. */
+    int ok = 1;
+    wal.autoCommit = 0;
+    for (long done = 0; ok && done < cfg->students;) {
+        long n = cfg->students - done < BENCH_BATCH ? cfg->students - done : BENCH_BATCH;
+        for (long i = 0; i < n; i++) {
+            benchStudent(b, &batch[i]);
+            strcpy(b->ids[b->live++], batch[i].id);
+        }
+        ok = storeAppendBatch(batch, n) >= 0;
+        done += n;
+    }
+    free(batch);
+    if (ok) {
+        indexesRebuild();
+        ok = dbSettle();
+    }
+
+    for (long i = 0; ok && i < cfg->tickets && b->live > 0; i++) {
+        char message[64];
+        snprintf(message, sizeof(message), "Synthetic ticket %ld", i + 1);
+        ok = ticketRaise(b->ids[benchPick(b, b->live)], message) > 0;
+        if (ok && benchPick(b, 2) == 0) ticketClose(ticketFirstOpen());
+        if (ok && (i + 1) % BENCH_TICKET_BATCH == 0) ok = walCommit(walLastLsn()) && walApplySynced();
+    }
+    wal.autoCommit = 1;
+    return ok && dbSettle() && autoExportCSV() >= 0;
 }
 
-void changePassword(char sid[]) {
+/* Run one operation; returns 1 on success. */
+int benchRun(Bench *b, int op) {
+    const char *id = b->live > 0 ? b->ids[benchPick(b, b->live)] : "none";
     Student s;
-    FILE *fp = fopen(STUD_FILE, "rb+");
-    if (!fp) {
-        printf("No student file.\n");
-        pauseScreen();
-        return;
+
+    switch (op) {
+        case BENCH_LOGIN: {
+            char pass[20];
+            defaultPasswordOf(id, pass, sizeof(pass));
+            return authStudent(id, pass);
+        }
+        case BENCH_LOOKUP:
+            return findStudent(id, &s, NULL);
+        case BENCH_UPDATE:
+            if (!findStudent(id, &s, NULL)) return 0;
+            s.cgpa = 5.0f + (float)benchPick(b, 501) / 100.0f;
+            return opUpdateStudent(&s) == NULL;
+        case BENCH_DELETE: {
+            long k = benchPick(b, b->live > 0 ? b->live : 1);
+            if (b->live == 0 || opDeleteStudent(b->ids[k]) != NULL) return 0;
+            if (k != --b->live) memcpy(b->ids[k], b->ids[b->live], sizeof(b->ids[k]));
+            return 1;
+        }
+        case BENCH_RAISE:
+            return ticketRaise(id, "Benchmark ticket") > 0;
+        case BENCH_CLOSE: {
+            int t = ticketFirstOpen();
+            return t > 0 && ticketClose(t) == 1;
+        }
+        case BENCH_SORT: {
+            if (!derivedEnsure(&cgpaIndex.di)) return 0;
+            for (long i = cgpaIndex.count - 1; i >= 0 && i >= cgpaIndex.count - BENCH_TOP_K; i--)
+                storeGet(cgpaIndex.recs[i]);
+            return 1;
+        }
+        case BENCH_EXPORT:
+            return autoExportCSV() >= 0;
+    }
+    return 0;
+}
+
+int benchRecord(BenchStat *st, double seconds, int ok) {
+    if (st->count == st->cap) {
+        long cap = st->cap ? st->cap * 2 : 1024;
+        double *lat = (double *)realloc(st->lat, sizeof(double) * (size_t)cap);
+        if (!lat) return 0;
+        st->lat = lat;
+        st->cap = cap;
     }
+    st->lat[st->count++] = seconds;
+    st->total += seconds;
+    if (!ok) st->failed++;
+    return 1;
+}
 
-    char newPass[20];
+int cmpDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
 
-    printf("\nEnter new password: ");
-    readLine(newPass, sizeof(newPass));
+double benchPercentile(const BenchStat *st, double p) {
+    return st->lat[(long)(p * (double)(st->count - 1) + 0.5)];
+}
 
-    while (fread(&s, sizeof(Student), 1, fp) == 1) {
-        if (strcmp(s.id, sid) == 0) {
-            strncpy(s.password, newPass, sizeof(s.password) - 1);
-            s.password[sizeof(s.password) - 1] = '\0';
-            fseek(fp, -(long)sizeof(Student), SEEK_CUR);
-            fwrite(&s, sizeof(Student), 1, fp);
-            break;
+void benchReport(Bench *b, double wall) {
+    long ops = 0;
+    printf("\n%-8s %8s %7s %10s %10s %10s %10s\n",
+           "op", "count", "failed", "p50 us", "p99 us", "max us", "ops/s");
+    for (int op = 0; op < BENCH_OP_COUNT; op++) {
+        BenchStat *st = &b->stats[op];
+        if (st->count == 0) continue;
+        qsort(st->lat, (size_t)st->count, sizeof(double), cmpDouble);
+        printf("%-8s %8ld %7ld %10.1f %10.1f %10.1f %10.0f\n", benchOpNames[op],
+               st->count, st->failed, benchPercentile(st, 0.50) * 1e6,
+               benchPercentile(st, 0.99) * 1e6, st->lat[st->count - 1] * 1e6,
+               st->count / st->total);
+        ops += st->count;
+    }
+    printf("%-8s %8ld %7s %10s %10s %10s %10.0f\n", "total", ops, "", "", "", "",
+           wall > 0 ? ops / wall : 0.0);
+}
+
+/* Parse "op=weight,..." into mix; returns 0 on an unknown op. */
+int benchParseMix(const char *spec, int *mix) {
+    char buf[256];
+    strncpy(buf, spec, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        char *eq = strchr(tok, '=');
+        int op;
+        if (!eq) return 0;
+        *eq = '\0';
+        for (op = 0; op < BENCH_OP_COUNT && strcmp(tok, benchOpNames[op]) != 0; op++) {}
+        if (op == BENCH_OP_COUNT || atoi(eq + 1) < 0) return 0;
+        mix[op] = atoi(eq + 1);
+    }
+    return 1;
+}
+
+void removeDirectory(const char *path) {
+    DIR *d = opendir(path);
+    struct dirent *e;
+    char file[PATH_MAX];
+    if (d) {
+        while ((e = readdir(d)) != NULL) {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+            snprintf(file, sizeof(file), "%s/%s", path, e->d_name);
+            unlink(file);
+        }
+        closedir(d);
+    }
+    rmdir(path);
+}
+
+int benchMain(int argc, char *argv[]) {
+    BenchConfig cfg = { BENCH_STUDENTS, BENCH_TICKETS, BENCH_OPS, 1, 0, { 0 } };
+    char dir[] = "/tmp/srms-bench-XXXXXX";
+    char home[PATH_MAX];
+    Bench b;
+    int weightSum = 0, ok;
+
+    memcpy(cfg.mix, benchDefaultMix, sizeof(cfg.mix));
+    for (int i = 2; i < argc; i++) {
+        const char *next = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--students") == 0 && next) cfg.students = atol(argv[++i]);
+        else if (strcmp(argv[i], "--tickets") == 0 && next) cfg.tickets = atol(argv[++i]);
+        else if (strcmp(argv[i], "--ops") == 0 && next) cfg.ops = atol(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && next) cfg.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--mix") == 0 && next) {
+            if (!benchParseMix(argv[++i], cfg.mix)) {
+                fprintf(stderr, "Bad --mix; ops are login, lookup, update, delete, "
+                                "raise, close, sort and export.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--keep") == 0) cfg.keep = 1;
+        else {
+            fprintf(stderr, "Unknown benchmark option %s\n", argv[i]);
+            return 1;
         }
     }
+    for (int op = 0; op < BENCH_OP_COUNT; op++) weightSum += cfg.mix[op];
+    if (cfg.students < 1 || cfg.tickets < 0 || cfg.ops < 0 || weightSum == 0) {
+        fprintf(stderr, "Nothing to benchmark.\n");
+        return 1;
+    }
 
-    fclose(fp);
+    if (!getcwd(home, sizeof(home)) || !mkdtemp(dir) || chdir(dir) != 0) {
+        perror("bench directory");
+        return 1;
+    }
 
-    printf("Password updated.\n");
-    pauseScreen();
+    memset(&b, 0, sizeof(b));
+    b.rng = cfg.seed ? cfg.seed : 1;
+    printf("SRMS benchmark in %s: %ld students, %ld tickets, %ld ops, seed %llu\n",
+           dir, cfg.students, cfg.tickets, cfg.ops, (unsigned long long)cfg.seed);
+
+    double start = nowSeconds();
+    ok = benchPopulate(&b, &cfg);
+    printf("Setup: %.3f s\n", nowSeconds() - start);
+
+    start = nowSeconds();
+    for (long i = 0; ok && i < cfg.ops; i++) {
+        long r = benchPick(&b, weightSum);
+        int op = 0;
+        while (r >= cfg.mix[op]) r -= cfg.mix[op++];
+
+        double t0 = nowSeconds();
+        int done = benchRun(&b, op);
+        ok = benchRecord(&b.stats[op], nowSeconds() - t0, done);
+    }
+    double wall = nowSeconds() - start;
+    if (ok) {
+        sessionFlush();
+        benchReport(&b, wall);
+    } else {
+        fprintf(stderr, "Benchmark aborted: could not build or write the database.\n");
+    }
+
+    for (int op = 0; op < BENCH_OP_COUNT; op++) free(b.stats[op].lat);
+    free(b.ids);
+    storeClose();
+    ticketsClose();
+    walClose();
+    if (chdir(home) != 0) perror(home);
+    if (cfg.keep) printf("Database kept in %s\n", dir);
+    else removeDirectory(dir);
+    return ok ? 0 : 1;
 }
 
 /* ---------- MENUS ---------- */
@@ -654,7 +5294,10 @@ void managementMenu() {
         printf("7. Close Ticket\n");
         printf("8. Analytics (CGPA Stats)\n");
         printf("9. Sorting Options\n");
-        printf("10. Export Students to CSV\n");
+        printf("10. Export Students (CSV/TXT/JSON)\n");
+        printf("11. Compact Storage\n");
+        printf("12. Bulk Import from CSV\n");
+        printf("13. Search by Name\n");
         printf("0. Logout\n");
         printf("Choose: ");
         c = readInt();
@@ -669,29 +5312,34 @@ void managementMenu() {
             case 7: closeTicket(); break;
             case 8: showAnalytics(); break;
             case 9: sortStudentsMenu(); break;
-            case 10: exportToCSV(); break;
-            case 0: return;
+            case 10: exportStudents(); break;
+            case 11: compactStorage(); break;
+            case 12: importStudents(); break;
+            case 13: searchByName(); break;
+            case 0: sessionFlush(); return;
             default: printf("Invalid.\n"); pauseScreen();
         }
     }
 }
 
-void studentMenu(char sid[]) {
+void studentMenu(StudentSession *me) {
     int c;
     while (1) {
         printf("\n----- STUDENT MENU -----\n");
         printf("1. View My Details\n");
         printf("2. Raise Ticket\n");
         printf("3. Change Password\n");
+        printf("4. My Tickets\n");
         printf("0. Logout\n");
         printf("Choose: ");
         c = readInt();
 
         switch (c) {
-            case 1: viewMyDetails(sid); break;
-            case 2: raiseTicket(sid); break;
-            case 3: changePassword(sid); break;
-            case 0: return;
+            case 1: viewMyDetails(me); break;
+            case 2: raiseTicket(me->sid); break;
+            case 3: changePassword(me); break;
+            case 4: viewMyTickets(me->sid); break;
+            case 0: sessionFlush(); return;
             default: printf("Invalid.\n"); pauseScreen();
         }
     }
@@ -699,9 +5347,48 @@ void studentMenu(char sid[]) {
 
 /* ---------- MAIN ---------- */
 
-int main() {
+/* Hold an exclusive lock on LOCK_FILE for the life of the process, so two
+   processes never write the database at the same time. */
+int lockDatabase() {
+    int fd = open(LOCK_FILE, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        fprintf(stderr, "The student database is in use by another SRMS process "
+                        "(is a server running?).\n");
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    return 1;
+}
+
+/* Finish any writes an interrupted run left in the log. */
+int recoverDatabase() {
+    long n = walRecover();
+    if (n < 0) {
+        fprintf(stderr, "Cannot replay %s; the database was not opened.\n", WAL_FILE);
+        return 0;
+    }
+    if (n > 0) printf("Recovered %ld logged write(s) from an interrupted session.\n", n);
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
     int ch;
-    char sid[20];
+    StudentSession me;
+
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        const char *path = SOCK_PATH;
+        int threads = SERVER_THREADS;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+            else path = argv[i];
+        }
+        if (threads < 1) threads = 1;
+        if (!lockDatabase() || !recoverDatabase()) return 1;
+        return serveMain(path, threads);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) return benchMain(argc, argv);
+
+    if (!lockDatabase() || !recoverDatabase()) return 1;
 
     while (1) {
         printf("\n===== STUDENT RECORD MANAGEMENT SYSTEM =====\n");
@@ -716,10 +5403,11 @@ int main() {
             else { printf("Login failed.\n"); pauseScreen(); }
         }
         else if (ch == 2) {
-            if (studentLogin(sid)) studentMenu(sid);
+            if (studentLogin(&me)) studentMenu(&me);
             else { printf("Login failed.\n"); pauseScreen(); }
         }
         else if (ch == 0) {
+            sessionFlush();
             printf("\nExiting...\n");
             return 0;
         }